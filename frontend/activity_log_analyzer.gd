@@ -6,10 +6,14 @@ const LOG_PATH_ANDROID = "/sdcard/Documents/pico8/data/activity_log.txt"
 const LOG_PATH_WIN = "activity_log.txt"
 const STATS_FILE = "user://activity_stats.json"
 const UNIT_SECONDS = 3
+const READ_CHUNK_SIZE = 1 << 20
+const GUARD_BYTES = 256
 
 static var cached_data: Dictionary = {}
 static var file_lookup: Dictionary = {}
 
+var _play_run_regex := RegEx.create_from_string("[p_]+")
+
 # Static entry point for the Application
 static func perform_analysis(force_reset: bool = false):
 	var analyzer = ActivityLogAnalyzer.new()
@@ -83,115 +87,151 @@ func _run(force_reset: bool = false):
 		print("ActivityLogAnalyzer: Failed to open log file.")
 		return
 
-	var current_cart_key = ""
-	var current_sub_filename = ""
-	var is_in_play_session = false
-	var last_line_time = 0
+	# The log only grows: resume at the checkpoint if the bytes before it are still the ones we read.
+	# Otherwise (no checkpoint yet, truncated or rotated log) start over, and the timestamp filter
+	# keeps already counted sessions from being counted twice.
+	var length = file.get_length()
+	var offset = int(data.get("log_offset", 0))
+	var resumed = offset > 0 and offset <= length and _guard_hash(file, offset) == data.get("log_guard", "")
+	var state = {"cart": "", "sub": "", "play": false, "time": 0}
+	if resumed:
+		state = data.get("log_state", state)
+		if offset == length:
+			print("ActivityLogAnalyzer: No new log data.")
+			_finish(data)
+			return
+	else:
+		if offset > 0:
+			print("ActivityLogAnalyzer: Log truncated or rotated, rescanning from the start.")
+		offset = 0
+	# Everything past a verified checkpoint is new; a rescan only counts what's newer than the last run
+	var min_time = 0 if resumed else int(data.last_analyzed_time)
+
+	print("ActivityLogAnalyzer: Reading %d bytes from offset %d" % [length - offset, offset])
+	file.seek(offset)
+	var carry = PackedByteArray()
+	while offset + carry.size() < length:
+		var chunk = carry + file.get_buffer(min(READ_CHUNK_SIZE, length - offset - carry.size()))
+		# Only complete lines; PICO-8 may be in the middle of appending the last one
+		var end = chunk.rfind(10) + 1
+		if end == 0:
+			if offset + chunk.size() >= length:
+				break
+			carry = chunk
+			continue
+		_fold_lines(chunk.slice(0, end).get_string_from_utf8(), data, state, min_time)
+		offset += end
+		carry = chunk.slice(end)
+
+	data.log_offset = offset
+	data.log_guard = _guard_hash(file, offset)
+	data.log_state = state
+	if state.time > data.last_analyzed_time:
+		data.last_analyzed_time = state.time
+	_save_stats(data)
+	_finish(data)
 
-	while not file.eof_reached():
-		var line = file.get_line()
+func _finish(data: Dictionary):
+	# Update cache with final data
+	ActivityLogAnalyzer.cached_data = data
+	ActivityLogAnalyzer._rebuild_lookup(data)
+		
+	_print_report(data)
+	
+	# Trigger Background Metadata Enrichment
+	# Ensure the class is loaded
+	var metadata_cache = load("res://metadata_cache.gd")
+	if metadata_cache:
+		metadata_cache.run_enrichment_async(data)
+
+# Hash of the GUARD_BYTES before offset, to tell an appended log from a replaced one
+func _guard_hash(file: FileAccess, offset: int) -> String:
+	var start = max(0, offset - GUARD_BYTES)
+	file.seek(start)
+	return file.get_buffer(offset - start).sha256_buffer().hex_encode()
+
+# Fold complete log lines into data. state carries the current cart/session across calls (and runs).
+func _fold_lines(text: String, data: Dictionary, state: Dictionary, min_time: int):
+	for line in text.split("\n", false):
+		line = line.trim_suffix("\r") # CRLF logs (Windows), get_line() used to drop it
 		if line.strip_edges().is_empty():
 			continue
 
 		# Check if line is a Header (Timestamp + Filename)
 		# Format: YYYY-MM-DD HH:MM:SS /path/to/cart.p8...
 		if line.length() > 19 and line[4] == "-" and line[13] == ":":
-			# It's a header
-			# Parse Timestamp
-			var time_str = line.substr(0, 19)
-			var dict = Time.get_datetime_dict_from_datetime_string(time_str, false)
-			var unix_time = Time.get_unix_time_from_datetime_dict(dict)
-			
-			last_line_time = unix_time
-			
-			# Optimization: Skip if we already analyzed this deep (UNLESS DEBUG_RESET is true or we are rebuilding)
-			# Only process if unix_time >= data.last_analyzed_time
+			var unix_time = Time.get_unix_time_from_datetime_string(line.substr(0, 19))
+			state.time = unix_time
+			state.play = false
 			
 			# Extract Cart Name
 			var parts = line.split(" ", false, 2)
 			# parts[0]=Date, parts[1]=Time, parts[2]=Path
-			if parts.size() >= 3:
-				var full_path = parts[2].strip_edges()
-				var filename = full_path.get_file()
-				
-				if filename == "untitled.p8":
-					current_cart_key = ""
-					current_sub_filename = ""
-					is_in_play_session = false
-				else:
-					# Use Base Name Key (grouping split carts)
-					current_cart_key = _get_base_cart_name(filename)
-					current_sub_filename = filename # Track for session
-					
-					# Only count launch if we are processing new data
-					if unix_time > data.last_analyzed_time:
-						if not data.carts.has(current_cart_key):
-							data.carts[current_cart_key] = {"launches": 0, "seconds": 0, "sub_carts": {}}
-						
-						var entry = data.carts[current_cart_key]
-						
-						# Ensure sub_cart entry exists (handle migration/fixes)
-						if not entry.has("sub_carts") or typeof(entry.sub_carts) != TYPE_DICTIONARY:
-							entry.sub_carts = {}
-						
-						if not entry.sub_carts.has(filename):
-							entry.sub_carts[filename] = {"launches": 0, "seconds": 0}
-						
-						# Aggregate Increment
-						entry.launches += 1
-						# Sub-cart Increment
-						entry.sub_carts[filename].launches += 1
-						
-					# Reset play session state for new cart load
-					is_in_play_session = false
-			else:
-				current_cart_key = ""
-				is_in_play_session = false
-				
+			if parts.size() < 3:
+				state.cart = ""
+				continue
+			var filename = parts[2].strip_edges().get_file()
+			if filename == "untitled.p8":
+				state.cart = ""
+				state.sub = ""
+				continue
+
+			# Use Base Name Key (grouping split carts)
+			state.cart = _get_base_cart_name(filename)
+			state.sub = filename # Track for session
+			if unix_time <= min_time:
+				continue
+			if not data.carts.has(state.cart):
+				data.carts[state.cart] = {"launches": 0, "seconds": 0, "sub_carts": {}}
+			
+			var entry = data.carts[state.cart]
+			
+			# Ensure sub_cart entry exists (handle migration/fixes)
+			if not entry.has("sub_carts") or typeof(entry.sub_carts) != TYPE_DICTIONARY:
+				entry.sub_carts = {}
+			
+			if not entry.sub_carts.has(filename):
+				entry.sub_carts[filename] = {"launches": 0, "seconds": 0}
+			
+			# Aggregate Increment
+			entry.launches += 1
+			# Sub-cart Increment
+			entry.sub_carts[filename].launches += 1
 		else:
 			# It's a data line (p..._...m...)
-			if current_cart_key == "":
+			if state.cart == "" or state.time <= min_time or not data.carts.has(state.cart):
 				continue
-				
-			# Only process duration if this block belongs to a timestamp > last_analyzed
-			if last_line_time <= data.last_analyzed_time:
+			var units = _count_play_units(line, state)
+			if units == 0:
 				continue
-				
-			# Count characters
-			# Optimization: analyze block instead of char-by-char if possible, but state matters
-			for i in range(line.length()):
-				var c = line[i]
-				
-				if c == "p":
-					is_in_play_session = true
-					data.carts[current_cart_key].seconds += UNIT_SECONDS
-					# Update sub-cart stats
-					if not current_sub_filename.is_empty():
-						data.carts[current_cart_key].sub_carts[current_sub_filename].seconds += UNIT_SECONDS
-						
-				elif c == "_" and is_in_play_session:
-					data.carts[current_cart_key].seconds += UNIT_SECONDS
-					# Update sub-cart stats
-					if not current_sub_filename.is_empty():
-						data.carts[current_cart_key].sub_carts[current_sub_filename].seconds += UNIT_SECONDS
-				else:
-					is_in_play_session = false
+			var entry = data.carts[state.cart]
+			entry.seconds += units * UNIT_SECONDS
+			if not state.sub.is_empty() and entry.sub_carts.has(state.sub):
+				entry.sub_carts[state.sub].seconds += units * UNIT_SECONDS
 
-	# Update persistent timestamp
-	if last_line_time > data.last_analyzed_time:
-		data.last_analyzed_time = last_line_time
-		_save_stats(data)
-	
-	# Update cache with final data
-	ActivityLogAnalyzer.cached_data = data
-		
-	_print_report(data)
-	
-	# Trigger Background Metadata Enrichment
-	# Ensure the class is loaded
-	var metadata_cache = load("res://metadata_cache.gd")
-	if metadata_cache:
-		metadata_cache.run_enrichment_async(data)
+# One char per UNIT_SECONDS: 'p' starts (or continues) play, '_' continues it, anything else stops it.
+# Counted per run of [p_] with the regex engine instead of char by char.
+func _count_play_units(line: String, state: Dictionary) -> int:
+	var units = 0
+	var play = state.play
+	var runs = _play_run_regex.search_all(line)
+	if runs.is_empty():
+		play = false
+	for m in runs:
+		var run = m.get_string()
+		if m.get_start() > 0:
+			play = false # Interrupted by some other char
+		if play:
+			units += run.length()
+		else:
+			var first_p = run.find("p")
+			if first_p >= 0:
+				units += run.length() - first_p
+				play = true
+		if m.get_end() < line.length():
+			play = false
+	state.play = play
+	return units
 
 # Helper to normalize cart names
 # "game-0.p8.png" -> "game.p8.png" (or just "game")
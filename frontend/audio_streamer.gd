@@ -1,129 +1,276 @@
 extends Node
 class_name AudioStreamer
 
+# Direct PCM channel from the shim (PICO_AUDIO_DIRECT=1, see run_pico_cmd.gd).
+# The shim runs PICO-8's SDL audio callback itself and writes to tmp/pico8.aud:
+# "PICO8AUD"(8) + Freq(4) + Channels(1) + Format(1) + Pad(2) each time it connects,
+# then interleaved frames. Format 1 = f32 stereo (Godot's AudioFrame layout), 0 = s16.
+
 # Audio Settings
-const MIX_RATE = 22050 # Optimized rate
-const BUFFER_SIZE_SECONDS = 0.1
-const TARGET_BUFFER_LENGTH = 0.1
-const TCP_HOST = "127.0.0.1"
-const TCP_PORT = 18081
-const BYTES_PER_SAMPLE = 2 # 16-bit mono = 2 bytes * 1 channel
+const MIX_RATE = 22050 # Optimized rate, until the shim's header says otherwise
+const GENERATOR_CAPACITY_SECONDS = 0.25 # Room in the generator, not latency: latency is how full we keep it
 const READ_CHUNK_SIZE = 4096
 
+const FORMAT_S16 = 0
+const FORMAT_F32 = 1
+
+const HEADER_MAGIC = "PICO8AUD"
+const HEADER_SIZE = 16
+# The shim writes continuously (silence while PICO-8 pauses its own audio), so a silent pipe means PICO-8
+# went away. Except while it is paused through the control channel (CTL_OP_PAUSE): then nothing is written
+# until the resume, and the pipe is kept open.
+const STALL_REOPEN_MS = 500
+const PAUSED_POLL_MS = 20
+
+# Adaptive jitter buffer: target = MIN_LATENCY + JITTER_FACTOR * arrival jitter (RFC 3550 estimator).
+# The fill level is steered towards it by nudging the playback rate, never by dropping audio,
+# except past OVERRUN_SECONDS (e.g. after PICO-8 was suspended and flushed a backlog).
+const MIN_LATENCY_SECONDS = 0.03
+const MAX_LATENCY_SECONDS = 0.15
+const JITTER_FACTOR = 3.0
+const RATE_MAX_STEP = 0.01 # At most 1% faster/slower (inaudible), ~10ms of drift corrected per second
+const RATE_DEADBAND = 0.15 # Fraction of the target tolerated before adjusting
+const OVERRUN_SECONDS = 0.3
+const STATS_INTERVAL_MS = 10000
+
+var PIPE_AUD = PicoBootManager.APPDATA_FOLDER + "/package/tmp/pico8.aud"
+
 var playback: AudioStreamGeneratorPlayback
 var player: AudioStreamPlayer
-var tcp: StreamPeerTCP
-var connection_status: int = StreamPeerTCP.STATUS_NONE
+var mix_rate: int = MIX_RATE
+
+# Stats (main thread)
+var underruns: int = 0 # Generator ran dry (AudioStreamGeneratorPlayback skips)
+var overruns: int = 0 # Backlog dropped past OVERRUN_SECONDS
+var target_latency_ms: float = MIN_LATENCY_SECONDS * 1000.0
+var buffered_ms: float = 0.0
+
+var _applinks_plugin = null
+var _thread: Thread
+var _thread_active: bool = false
+var _mutex: Mutex
+var _pipe_id: int = -1
+var _retry_ms: int = PicoVideoStreamer.PIPE_RETRY_MIN_MS
+
+# Reader thread -> main thread (under _mutex): converted chunks, stream format, jitter estimate
+var _pending_chunks: Array[PackedVector2Array] = []
+var _pending_rate: int = 0
+var _jitter_s: float = 0.0
 
-var _buffer: PackedByteArray = PackedByteArray()
+# Reader thread only
+var _format: int = FORMAT_S16
+var _channels: int = 1
+var _carry: PackedByteArray = PackedByteArray()
+var _last_arrival_us: int = 0
+var _vec2_header: PackedByteArray
+
+# Main thread only
+var _chunks: Array[PackedVector2Array] = []
+var _queued_frames: int = 0
+var _priming: bool = true
+var _last_skips: int = 0
+var _last_stats_time: int = 0
 
 func _ready():
 	_setup_audio()
-	_connect_tcp()
+	# Variant header for bytes_to_var: PackedVector2Array + element count, data follows
+	_vec2_header.resize(8)
+	_vec2_header.encode_u32(0, TYPE_PACKED_VECTOR2_ARRAY)
+	if Engine.has_singleton("applinks"):
+		_applinks_plugin = Engine.get_singleton("applinks")
+	else:
+		print("AudioStreamer: Applinks Plugin NOT FOUND, no audio")
+		return
+	_mutex = Mutex.new()
+	_thread_active = true
+	_thread = Thread.new()
+	_thread.start(_thread_function)
+
+func _exit_tree():
+	# Like the video thread, don't join: it may be blocked inside pipe_open
+	_thread_active = false
 
 func _setup_audio():
+	if player:
+		player.queue_free()
 	player = AudioStreamPlayer.new()
 	var generator = AudioStreamGenerator.new()
-	generator.mix_rate = MIX_RATE
-	generator.buffer_length = BUFFER_SIZE_SECONDS
+	generator.mix_rate = mix_rate
+	generator.buffer_length = GENERATOR_CAPACITY_SECONDS
 	player.stream = generator
 	add_child(player)
 	player.play()
 	playback = player.get_stream_playback()
+	_last_skips = 0
+	_priming = true
 
-func _connect_tcp():
-	tcp = StreamPeerTCP.new()
-	print("AudioStreamer: Attempting connection to ", TCP_HOST, ":", TCP_PORT)
-	var err = tcp.connect_to_host(TCP_HOST, TCP_PORT)
-	if err != OK:
-		print("AudioStreamer: Failed to connect to host. Error Code: ", err)
-	else:
-		print("AudioStreamer: Connection initiated...")
+func _thread_function():
+	var last_data_time = Time.get_ticks_msec()
+	while _thread_active:
+		if _pipe_id == -1:
+			print("AudioStreamer: Attempting to connect to Audio Pipe...")
+			# Blocks until the shim opens its end
+			_pipe_id = _applinks_plugin.pipe_open(PIPE_AUD, 0) # Mode 0 = READ
+			if _pipe_id == -1:
+				OS.delay_msec(_retry_ms)
+				_retry_ms = mini(_retry_ms * 2, PicoVideoStreamer.PIPE_RETRY_MAX_MS)
+				continue
+			_retry_ms = PicoVideoStreamer.PIPE_RETRY_MIN_MS
+			print("AudioStreamer: Connected to Audio Pipe (ID: ", _pipe_id, ")")
+			last_data_time = Time.get_ticks_msec()
+			_carry.clear()
+			_last_arrival_us = 0
+
+		var chunk: PackedByteArray = _applinks_plugin.pipe_read(_pipe_id, READ_CHUNK_SIZE)
+		if chunk.is_empty():
+			if _pico_paused():
+				last_data_time = Time.get_ticks_msec() # The stall timeout starts over at the resume
+				OS.delay_msec(PAUSED_POLL_MS)
+			elif Time.get_ticks_msec() - last_data_time > STALL_REOPEN_MS:
+				# Writer gone (restart recreates the FIFO): reopen to follow the new one
+				_applinks_plugin.pipe_close(_pipe_id)
+				_pipe_id = -1
+			else:
+				OS.delay_msec(2)
+			continue
+		last_data_time = Time.get_ticks_msec()
+
+		# The shim starts every connection with a header; it is written in one piece
+		if chunk.size() >= HEADER_SIZE and chunk.slice(0, HEADER_MAGIC.length()).get_string_from_ascii() == HEADER_MAGIC:
+			var rate = chunk.decode_u32(8)
+			_channels = max(1, chunk[12])
+			_format = chunk[13]
+			print("AudioStreamer: Stream format ", rate, " Hz, ", _channels, " ch, format ", _format)
+			chunk = chunk.slice(HEADER_SIZE)
+			_carry.clear()
+			_last_arrival_us = 0
+			_mutex.lock()
+			_pending_rate = rate
+			_mutex.unlock()
+
+		if not _carry.is_empty():
+			_carry.append_array(chunk)
+			chunk = _carry
+			_carry = PackedByteArray()
+		var frame_bytes = _channels * (4 if _format == FORMAT_F32 else 2)
+		var usable = chunk.size() - chunk.size() % frame_bytes
+		if usable < chunk.size():
+			_carry = chunk.slice(usable)
+			chunk = chunk.slice(0, usable)
+		if chunk.is_empty():
+			continue
+
+		var frames = _convert(chunk, usable / frame_bytes)
+		_track_jitter(frames.size())
+		_mutex.lock()
+		_pending_chunks.append(frames)
+		_mutex.unlock()
 
-var last_connect_attempt_time = 0
-const RECONNECT_DELAY_MS = 50 # Try every 50ms (20 times per second)
+# From send_control(CTL_OP_PAUSE) until the resume, including the time before the shim acks it
+func _pico_paused() -> bool:
+	return PicoVideoStreamer.instance != null and PicoVideoStreamer.instance.pause_requested
+
+# Bytes -> stereo frames. f32 stereo is reinterpreted natively, no per-sample GDScript.
+func _convert(chunk: PackedByteArray, frame_count: int) -> PackedVector2Array:
+	if _format == FORMAT_F32 and _channels == 2:
+		_vec2_header.encode_u32(4, frame_count)
+		return bytes_to_var(_vec2_header + chunk)
+
+	var frames = PackedVector2Array()
+	frames.resize(frame_count)
+	for i in range(frame_count):
+		var idx = i * _channels * 2
+		var left = chunk.decode_s16(idx) / 32768.0
+		var right = chunk.decode_s16(idx + 2) / 32768.0 if _channels == 2 else left
+		frames[i] = Vector2(left, right)
+	return frames
+
+# RFC 3550 style interarrival jitter: smoothed |difference between arrival spacing and media spacing|
+func _track_jitter(frame_count: int):
+	var now = Time.get_ticks_usec()
+	if _last_arrival_us > 0:
+		var rate = float(max(1, mix_rate))
+		var d = (now - _last_arrival_us) / 1000000.0 - frame_count / rate
+		_mutex.lock()
+		_jitter_s += (abs(d) - _jitter_s) / 16.0
+		_mutex.unlock()
+	_last_arrival_us = now
 
 func _process(_delta):
-	tcp.poll()
-	var status = tcp.get_status()
-	
-	if status != connection_status:
-		connection_status = status
-		match status:
-			StreamPeerTCP.STATUS_CONNECTING:
-				# print("AudioStreamer: Connecting...")
-				pass
-			StreamPeerTCP.STATUS_CONNECTED:
-				print("AudioStreamer: Connected!")
-				tcp.set_no_delay(true)
-			StreamPeerTCP.STATUS_ERROR:
-				print("AudioStreamer: Connection Error!")
-			StreamPeerTCP.STATUS_NONE:
-				print("AudioStreamer: Disconnected.")
-
-	if status == StreamPeerTCP.STATUS_CONNECTED:
-		_read_data()
-		_playback_audio()
-	elif status == StreamPeerTCP.STATUS_NONE or status == StreamPeerTCP.STATUS_ERROR:
-		var now = Time.get_ticks_msec()
-		if now - last_connect_attempt_time > RECONNECT_DELAY_MS:
-			last_connect_attempt_time = now
-			_connect_tcp()
-
-func _read_data():
-	var available_bytes = tcp.get_available_bytes()
-	if available_bytes > 0:
-		var data = tcp.get_data(available_bytes)
-		if data[0] == OK:
-			var bytes = data[1]
-			_buffer.append_array(bytes)
-			
-			# Latency Control: If buffer gets too big (more than 0.15s), drop oldest data
-			# 0.15s * MIX_RATE * BYTES_PER_SAMPLE
-			var max_buffer_bytes = int(0.15 * MIX_RATE * BYTES_PER_SAMPLE)
-			if _buffer.size() > max_buffer_bytes:
-				# Keep only the newest portion to catch up
-				var keep_bytes = int(0.1 * MIX_RATE * BYTES_PER_SAMPLE)
-				var drop_count = _buffer.size() - keep_bytes
-				# Ensure alignment to sample size (2 bytes)
-				drop_count = drop_count - (drop_count % BYTES_PER_SAMPLE)
-				
-				if drop_count > 0:
-					_buffer = _buffer.slice(drop_count)
-					# print("AudioStreamer: Dropped ", drop_count, " bytes to reduce latency")
-
-func _playback_audio():
-	if not playback: return
-	
+	if not _mutex:
+		return
+	_mutex.lock()
+	var rate = _pending_rate
+	_pending_rate = 0
+	var incoming = _pending_chunks
+	_pending_chunks = []
+	var jitter = _jitter_s
+	_mutex.unlock()
+
+	if rate > 0 and rate != mix_rate:
+		mix_rate = rate
+		_chunks.clear()
+		_queued_frames = 0
+		_setup_audio()
+
+	for frames in incoming:
+		_chunks.append(frames)
+		_queued_frames += frames.size()
+
+	if not playback:
+		return
+
+	var skips = playback.get_skips()
+	if skips > _last_skips:
+		underruns += 1
+		_priming = true
+	_last_skips = skips
+
+	target_latency_ms = clamp(MIN_LATENCY_SECONDS + JITTER_FACTOR * jitter, MIN_LATENCY_SECONDS, MAX_LATENCY_SECONDS) * 1000.0
+	var capacity = int(GENERATOR_CAPACITY_SECONDS * mix_rate)
+	var in_generator = capacity - playback.get_frames_available()
+	var target_frames = int(target_latency_ms / 1000.0 * mix_rate)
+
+	# Way behind (e.g. resumed after a suspend): the only case where audio is dropped
+	while _queued_frames + in_generator > int(OVERRUN_SECONDS * mix_rate) and _chunks.size() > 1:
+		_queued_frames -= _chunks.pop_front().size()
+		overruns += 1
+
+	# (Re)start only once the target is buffered, so a dry generator doesn't stutter in and out
+	if _priming:
+		if _queued_frames + in_generator < target_frames:
+			return
+		_priming = false
+
+	_feed_generator()
+
+	# Steer the fill level towards the target with a small resampling step
+	var buffered = _queued_frames + capacity - playback.get_frames_available()
+	buffered_ms = buffered * 1000.0 / mix_rate
+	var error = (buffered - target_frames) / float(max(1, target_frames))
+	if abs(error) < RATE_DEADBAND:
+		player.pitch_scale = 1.0
+	else:
+		player.pitch_scale = 1.0 + clamp(error * RATE_MAX_STEP, -RATE_MAX_STEP, RATE_MAX_STEP)
+
+	var now = Time.get_ticks_msec()
+	if now - _last_stats_time > STATS_INTERVAL_MS:
+		_last_stats_time = now
+		print("AudioStreamer: buffered %.1f ms (target %.1f, jitter %.1f) | underruns %d | overruns %d" % [
+			buffered_ms, target_latency_ms, jitter * 1000.0, underruns, overruns])
+
+# Push whole queued chunks while they fit; only a chunk split at the end is copied
+func _feed_generator():
 	var frames_available = playback.get_frames_available()
-	if frames_available <= 0: return
-
-	# Convert bytes to Vector2 frames
-	# 1 frame = 2 bytes (1 sample) -> Stereo Output (Sample, Sample)
-	
-	# Only push if we have enough data (or push whatever we have?)
-	var buffer_frames = int(_buffer.size() / BYTES_PER_SAMPLE)
-	var push_count = min(buffer_frames, frames_available)
-	
-	if push_count > 0:
-		#print("Pushing audio frames: ", push_count)
-		var frames = PackedVector2Array()
-		frames.resize(push_count)
-		
-		# Efficiently decode bytes to Audio Frames
-		for i in range(push_count):
-			var idx = i * 2 # 2 bytes per sample (Mono)
-			# s16le decoding
-			var sample_val = _buffer.decode_s16(idx)
-			
-			# Normalize short (-32768..32767) to float (-1.0..1.0)
-			var val = sample_val / 32768.0
-			
-			# Create stereo frame from mono source
-			frames[i] = Vector2(val, val)
-			
-		playback.push_buffer(frames)
-		
-		# Remove consumed bytes
-		var consumed_bytes = push_count * BYTES_PER_SAMPLE
-		_buffer = _buffer.slice(consumed_bytes)
+	while frames_available > 0 and not _chunks.is_empty():
+		var frames: PackedVector2Array = _chunks[0]
+		if frames.size() <= frames_available:
+			playback.push_buffer(frames)
+			_chunks.pop_front()
+			frames_available -= frames.size()
+			_queued_frames -= frames.size()
+		else:
+			playback.push_buffer(frames.slice(0, frames_available))
+			_chunks[0] = frames.slice(frames_available)
+			_queued_frames -= frames_available
+			frames_available = 0
@@ -52,6 +52,13 @@ static var APPDATA_FOLDER: String:
 		return ProjectSettings.globalize_path("user://").trim_suffix("/")
 static var PUBLIC_FOLDER = "/sdcard/Documents/pico8"
 
+# Time-to-first-frame marks, {phase: wall clock usec mod 2^32} (the clock the shim stamps its phases with).
+# PicoVideoStreamer logs them with the shim's phases when the first frame arrives, then clears them.
+static var boot_marks: Dictionary = {}
+
+static func mark_boot_phase(phase: String) -> void:
+	boot_marks[phase] = PicoVideoStreamer._input_timestamp()
+
 static func sanitize_uri(uri: String) -> String:
 	if not uri.begins_with("content://"):
 		return uri
@@ -304,6 +311,7 @@ func setup():
 	load_sdl_mappings()
 
 	# Setup is complete, go to main scene
+	mark_boot_phase("package check")
 	get_tree().change_scene_to_file("res://main.tscn")
 
 
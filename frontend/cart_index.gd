@@ -0,0 +1,320 @@
+class_name CartIndex
+extends RefCounted
+
+# Persistent index of the local BBS cart cache (bbs/<subfolder>/<id>.nfo + .p8.png), keyed by cart id.
+# INDEX_FILE is an append-only log of JSON lines, later lines win:
+#   {"id": ..., <entry fields>}    upsert a cart
+#   {"id": ..., "del": true}       remove a cart
+#   {"dir": ..., "mtime": ...}     directory scanned at that mtime
+# It is compacted (rewritten with one line per live record) once it holds COMPACT_RATIO times
+# more lines than live records.
+# Entry fields: id, lid, mid, title, author, ts, catsub, nfo, mtime (of the .nfo), png, launches, seconds.
+# Carts only known from the activity log have nfo == "".
+
+const INDEX_FILE = "user://cart_index.jsonl"
+const LEGACY_METADATA_FILE = "user://cart_metadata.json"
+const COMPACT_RATIO = 2
+const COMPACT_MIN_LINES = 256
+const NFO_FIELDS = ["lid", "mid", "title", "author", "ts", "catsub"]
+# Where the label sits inside a .p8.png
+const LABEL_RECT = Rect2i(16, 24, 128, 128)
+
+enum Sort {RECENT, NAME}
+
+# _mutex guards _entries/_dirs against readers; _write_mutex serializes refresh and stats updates,
+# which read without _mutex and only take it to apply their changes.
+static var _mutex := Mutex.new()
+static var _write_mutex := Mutex.new()
+static var _entries: Dictionary = {}
+static var _dirs: Dictionary = {}
+static var _loaded := false
+static var _log_lines := 0
+static var _pending: PackedStringArray = []
+
+# Cheap once loaded; call from a worker thread, the first load reads the whole log
+static func ensure_loaded():
+	_write_mutex.lock()
+	if not _loaded:
+		_load()
+	_write_mutex.unlock()
+
+static func is_loaded() -> bool:
+	return _loaded
+
+# Local carts (the ones with an .nfo), newest first or by title
+static func query(sort: Sort = Sort.RECENT, limit: int = -1) -> Array:
+	var result = []
+	_mutex.lock()
+	for id in _entries:
+		var entry = _entries[id]
+		if not entry.get("nfo", "").is_empty():
+			result.append(entry.duplicate())
+	_mutex.unlock()
+	if sort == Sort.RECENT:
+		result.sort_custom(func(a, b): return a.mtime > b.mtime)
+	else:
+		result.sort_custom(func(a, b): return _display_name(a).naturalnocasecmp_to(_display_name(b)) < 0)
+	if limit >= 0 and result.size() > limit:
+		result.resize(limit)
+	return result
+
+static func _display_name(entry: Dictionary) -> String:
+	var title = entry.get("title")
+	return entry.id if title == null or str(title).is_empty() else str(title)
+
+static func get_entry(id: String) -> Dictionary:
+	_mutex.lock()
+	var entry = _entries.get(id, {}).duplicate()
+	_mutex.unlock()
+	return entry
+
+# Incremental rescan of the bbs folder. Directories whose mtime is unchanged are not listed again,
+# only their known .nfo files are stat'ed. Returns true if anything changed. Worker thread only.
+static func refresh() -> bool:
+	_write_mutex.lock()
+	if not _loaded:
+		_load()
+	var base_path = MetadataCache.get_pico8_data_path()
+	var upserts = {}
+	var deletes = {}
+	var dir_updates = {}
+	var unchanged_dirs = {}
+	var now = int(Time.get_unix_time_from_system())
+
+	if DirAccess.dir_exists_absolute(base_path):
+		for sub in DirAccess.get_directories_at(base_path):
+			var dir_path = base_path.path_join(sub)
+			var mtime = FileAccess.get_modified_time(dir_path)
+			# A directory changed within the last second may change again within the same mtime
+			if mtime >= now - 1:
+				mtime = -1
+			if mtime != -1 and int(_dirs.get(dir_path, -2)) == mtime:
+				unchanged_dirs[dir_path] = true
+				continue
+			_scan_dir(dir_path, upserts, deletes)
+			dir_updates[dir_path] = mtime
+
+	for dir_path in _dirs:
+		if not unchanged_dirs.has(dir_path) and not dir_updates.has(dir_path):
+			dir_updates[dir_path] = null # Gone
+
+	for id in _entries:
+		var entry = _entries[id]
+		var nfo: String = entry.get("nfo", "")
+		if nfo.is_empty():
+			continue
+		var dir_path = nfo.get_base_dir()
+		if unchanged_dirs.has(dir_path):
+			if not FileAccess.file_exists(nfo):
+				deletes[id] = true
+			elif FileAccess.get_modified_time(nfo) != int(entry.mtime):
+				var updated = _entry_from_nfo(id, nfo, entry)
+				if not updated.is_empty():
+					upserts[id] = updated
+		elif dir_updates.has(dir_path) and dir_updates[dir_path] == null:
+			deletes[id] = true
+
+	var changed = not upserts.is_empty() or not deletes.is_empty()
+	_mutex.lock()
+	for id in deletes:
+		if upserts.has(id):
+			continue
+		var entry = _entries.get(id)
+		if entry == null:
+			continue
+		if entry.get("launches", 0) > 0:
+			# Keep play stats for carts that were removed from the cache
+			entry = entry.duplicate()
+			entry.nfo = ""
+			entry.png = ""
+			_put(entry)
+		else:
+			_entries.erase(id)
+			_pending.append(JSON.stringify({"id": id, "del": true}))
+	for id in upserts:
+		_put(upserts[id])
+	for dir_path in dir_updates:
+		if dir_updates[dir_path] == null:
+			_dirs.erase(dir_path)
+		else:
+			_dirs[dir_path] = dir_updates[dir_path]
+		_pending.append(JSON.stringify({"dir": dir_path, "mtime": dir_updates[dir_path]}))
+	_mutex.unlock()
+
+	_flush()
+	_write_mutex.unlock()
+	if changed:
+		print("CartIndex: %d updated, %d removed, %d carts indexed" % [upserts.size(), deletes.size(), _entries.size()])
+	return changed
+
+# Mirror activity log totals ({base_key: {launches, seconds, ...}}) into the index, appending only changes
+static func update_play_stats(carts: Dictionary):
+	_write_mutex.lock()
+	if not _loaded:
+		_load()
+	var updates = []
+	for key in carts:
+		var launches = int(carts[key].get("launches", 0))
+		var seconds = int(carts[key].get("seconds", 0))
+		var entry = _entries.get(key)
+		if entry == null:
+			entry = {"id": key, "nfo": "", "png": "", "mtime": 0}
+		elif int(entry.get("launches", 0)) == launches and int(entry.get("seconds", 0)) == seconds:
+			continue
+		else:
+			entry = entry.duplicate()
+		entry.launches = launches
+		entry.seconds = seconds
+		updates.append(entry)
+	_mutex.lock()
+	for entry in updates:
+		_put(entry)
+	_mutex.unlock()
+	_flush()
+	_write_mutex.unlock()
+
+static func _scan_dir(dir_path: String, upserts: Dictionary, deletes: Dictionary):
+	var seen = {}
+	for fname in DirAccess.get_files_at(dir_path):
+		if not fname.ends_with(".nfo"):
+			continue
+		var id = fname.trim_suffix(".nfo").trim_prefix("temp-")
+		var nfo = dir_path.path_join(fname)
+		var mtime = FileAccess.get_modified_time(nfo)
+		# id.nfo and temp-id.nfo can coexist: the newest one wins
+		if seen.has(id) and seen[id] >= mtime:
+			continue
+		seen[id] = mtime
+		var entry = _entries.get(id, {})
+		if entry.get("nfo", "") == nfo and int(entry.get("mtime", -1)) == mtime:
+			upserts.erase(id) # An older variant may have been queued first
+			continue
+		var updated = _entry_from_nfo(id, nfo, entry)
+		if not updated.is_empty():
+			upserts[id] = updated
+	for id in _entries:
+		if not seen.has(id) and _entries[id].get("nfo", "").get_base_dir() == dir_path:
+			deletes[id] = true
+
+static func _entry_from_nfo(id: String, nfo: String, previous: Dictionary) -> Dictionary:
+	var info = MetadataCache._parse_nfo(nfo)
+	if info.is_empty():
+		return {}
+	var entry = previous.duplicate()
+	entry.id = id
+	for field in NFO_FIELDS:
+		entry[field] = info.get(field, entry.get(field))
+	entry.nfo = nfo
+	entry.mtime = FileAccess.get_modified_time(nfo)
+	# The cart image is named after the lid, except for unlisted carts named after their numeric mid
+	var lid = "" if entry.get("lid") == null else str(entry.lid)
+	var mid = "" if entry.get("mid") == null else str(entry.mid)
+	var png_name = (mid if mid.is_valid_int() and not lid.is_valid_int() else lid) + ".p8.png"
+	var png = nfo.get_base_dir().path_join(png_name)
+	entry.png = png if not lid.is_empty() and FileAccess.file_exists(png) else ""
+	return entry
+
+# Caller holds _mutex
+static func _put(entry: Dictionary):
+	_entries[entry.id] = entry
+	_pending.append(JSON.stringify(entry))
+
+static func _load():
+	_loaded = true
+	_log_lines = 0
+	if not FileAccess.file_exists(INDEX_FILE):
+		_import_legacy_metadata()
+		return
+	var f = FileAccess.open(INDEX_FILE, FileAccess.READ)
+	if not f:
+		return
+	var entries = {}
+	var dirs = {}
+	while not f.eof_reached():
+		var line = f.get_line()
+		if line.is_empty():
+			continue
+		_log_lines += 1
+		var record = JSON.parse_string(line)
+		if typeof(record) != TYPE_DICTIONARY:
+			continue # Torn last line after a crash
+		if record.has("dir"):
+			if record.mtime == null:
+				dirs.erase(record.dir)
+			else:
+				dirs[record.dir] = int(record.mtime)
+		elif record.has("id"):
+			if record.get("del", false):
+				entries.erase(record.id)
+			else:
+				entries[record.id] = record
+	_mutex.lock()
+	_entries = entries
+	_dirs = dirs
+	_mutex.unlock()
+	print("CartIndex: Loaded %d carts (%d log lines)" % [entries.size(), _log_lines])
+
+# One-off migration from the JSON file MetadataCache used to rewrite on every change
+static func _import_legacy_metadata():
+	if not FileAccess.file_exists(LEGACY_METADATA_FILE):
+		return
+	var f = FileAccess.open(LEGACY_METADATA_FILE, FileAccess.READ)
+	if not f:
+		return
+	var legacy = JSON.parse_string(f.get_as_text())
+	if typeof(legacy) != TYPE_DICTIONARY:
+		return
+	_mutex.lock()
+	for key in legacy:
+		var entry = {"id": key, "nfo": "", "png": "", "mtime": 0}
+		for field in NFO_FIELDS:
+			entry[field] = legacy[key].get(field)
+		_put(entry)
+	_mutex.unlock()
+	_flush()
+	print("CartIndex: Imported %d entries from %s" % [legacy.size(), LEGACY_METADATA_FILE])
+
+# Caller holds _write_mutex
+static func _flush():
+	if _pending.is_empty():
+		return
+	var live = _entries.size() + _dirs.size()
+	if _log_lines + _pending.size() > max(COMPACT_MIN_LINES, live * COMPACT_RATIO):
+		_compact()
+		return
+	var f: FileAccess
+	if FileAccess.file_exists(INDEX_FILE):
+		f = FileAccess.open(INDEX_FILE, FileAccess.READ_WRITE)
+		if f:
+			f.seek_end()
+	else:
+		f = FileAccess.open(INDEX_FILE, FileAccess.WRITE)
+	if not f:
+		printerr("CartIndex: Could not open ", INDEX_FILE)
+		return
+	for line in _pending:
+		f.store_line(line)
+	_log_lines += _pending.size()
+	_pending.clear()
+
+# Rewrite the log with one line per live record; the rename keeps the old log valid until it's done
+static func _compact():
+	var tmp_path = INDEX_FILE + ".tmp"
+	var f = FileAccess.open(tmp_path, FileAccess.WRITE)
+	if not f:
+		printerr("CartIndex: Could not open ", tmp_path)
+		return
+	_mutex.lock()
+	for dir_path in _dirs:
+		f.store_line(JSON.stringify({"dir": dir_path, "mtime": _dirs[dir_path]}))
+	for id in _entries:
+		f.store_line(JSON.stringify(_entries[id]))
+	_log_lines = _entries.size() + _dirs.size()
+	_mutex.unlock()
+	f.close()
+	var err = DirAccess.rename_absolute(ProjectSettings.globalize_path(tmp_path), ProjectSettings.globalize_path(INDEX_FILE))
+	if err != OK:
+		printerr("CartIndex: Compaction failed (error %d)" % err)
+		return
+	_pending.clear()
+	print("CartIndex: Compacted to %d lines" % _log_lines)
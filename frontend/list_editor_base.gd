@@ -23,6 +23,7 @@ var popup_was_visible: bool = false
 var default_background_image = preload("res://icons/adaptive_top.png")
 
 var _scroll_tween: Tween
+var _background_key: String = "" # Thumbnail the focused item wants, later arrivals for other items are dropped
 
 # UI Accessors - Subclasses must provide these node paths or expected names in their scenes
 @onready var panel = $Panel
@@ -108,6 +109,23 @@ func _instantiate_item(_item_data, _index: int) -> Control:
 func _get_background_image_path(_item_data) -> String:
 	return ""
 
+# ThumbnailCache key for the item's background, "" for none. Default: cart_id + filename (favourites, stats)
+func _get_thumbnail_key(item_data) -> String:
+	var cart_id = str(_item_field(item_data, "cart_id"))
+	var filename = str(_item_field(item_data, "filename"))
+	if not cart_id.is_empty():
+		return ThumbnailCache.key(cart_id, filename)
+	if not filename.is_empty():
+		# Local carts have no version, the file's mtime stands in for it
+		var path = _get_background_image_path(item_data)
+		return ThumbnailCache.key("carts_" + filename, str(FileAccess.get_modified_time(path)))
+	return ""
+
+func _item_field(item_data, field: String):
+	if item_data is Dictionary:
+		return item_data.get(field, "")
+	return item_data.get(field) if item_data is Object and field in item_data else ""
+
 # ==========================================
 # LAYOUT & RENDERING
 # ==========================================
@@ -295,16 +313,20 @@ func _on_item_focused(item_data, item_node):
 	
 	_set_item_background(item_data)
 
+# The label comes from ThumbnailCache; on a miss the previous background stays up until a worker has it
 func _set_item_background(item_data) -> void:
-	var path = _get_background_image_path(item_data)
-	if not path.is_empty() and FileAccess.file_exists(path):
-		var img = Image.load_from_file(path)
-		if img and background_art:
-			background_art.texture = ImageTexture.create_from_image(img)
-		elif background_art:
-			background_art.texture = default_background_image
-	elif background_art:
+	if not background_art:
+		return
+	_background_key = _get_thumbnail_key(item_data)
+	if _background_key.is_empty():
 		background_art.texture = default_background_image
+		return
+	ThumbnailCache.request(_background_key, _get_background_image_path(item_data), _on_thumbnail_ready)
+
+func _on_thumbnail_ready(cache_key: String, img: Image):
+	if cache_key != _background_key or not is_instance_valid(background_art):
+		return
+	background_art.texture = ImageTexture.create_from_image(img) if img else default_background_image
 
 func _ensure_node_visible(node: Control, wait_for_layout: bool = true):
 	if wait_for_layout:
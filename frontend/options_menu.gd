@@ -53,6 +53,8 @@ func _ready() -> void:
 		%ToggleSwapZX.toggled.connect(_on_swap_zx_toggled)
 	if not %ToggleIntegerScaling.toggled.is_connected(_on_integer_scaling_toggled):
 		%ToggleIntegerScaling.toggled.connect(_on_integer_scaling_toggled)
+	if not %ToggleSmoothPacing.toggled.is_connected(_on_smooth_pacing_toggled):
+		%ToggleSmoothPacing.toggled.connect(_on_smooth_pacing_toggled)
 	if not %OptionShowControls.item_selected.is_connected(_on_show_controls_selected):
 		%OptionShowControls.item_selected.connect(_on_show_controls_selected)
 	if not %ToggleBezel.toggled.is_connected(_on_bezel_toggled):
@@ -67,6 +69,7 @@ func _ready() -> void:
 	%ButtonSwapZX.pressed.connect(_on_label_pressed.bind(%ToggleSwapZX))
 	%ButtonKeyboard.pressed.connect(_on_label_pressed.bind(%ToggleKeyboard))
 	%ButtonIntegerScaling.pressed.connect(_on_label_pressed.bind(%ToggleIntegerScaling))
+	%ButtonSmoothPacing.pressed.connect(_on_label_pressed.bind(%ToggleSmoothPacing))
 	%ButtonBezel.pressed.connect(_on_label_pressed.bind(%ToggleBezel))
 	if not %ButtonShowControls.pressed.is_connected(_on_show_controls_button_pressed):
 		%ButtonShowControls.pressed.connect(_on_show_controls_button_pressed)
@@ -395,7 +398,10 @@ func _update_layout():
 	# 4. Integer Scaling Row
 	_style_option_row(%ButtonIntegerScaling, %ToggleIntegerScaling, $SlidePanel/ScrollContainer/VBoxContainer/SectionDisplay/ContainerDisplay/ContentDisplay/IntegerScalingRow/WrapperIntegerScaling, dynamic_font_size, scale_factor)
 
-	# 4a. Bezel Row
+	# 4a. Smooth Frame Pacing Row
+	_style_option_row(%ButtonSmoothPacing, %ToggleSmoothPacing, $SlidePanel/ScrollContainer/VBoxContainer/SectionDisplay/ContainerDisplay/ContentDisplay/SmoothPacingRow/WrapperSmoothPacing, dynamic_font_size, scale_factor)
+
+	# 4b. Bezel Row
 	_style_option_row(%ButtonBezel, %ToggleBezel, $SlidePanel/ScrollContainer/VBoxContainer/SectionDisplay/ContainerDisplay/ContentDisplay/BezelRow/WrapperBezel, dynamic_font_size, scale_factor)
 
 	# 5. Show Controls Row
@@ -947,7 +953,7 @@ func _adjust_focused_slider(direction: int) -> bool:
 
 func _update_audio_label(is_stream: bool):
 	if %ButtonAudioBackendLabel:
-		%ButtonAudioBackendLabel.text = "TCP Stream" if is_stream else "SLES (Standard)"
+		%ButtonAudioBackendLabel.text = "Direct Stream" if is_stream else "SLES (Standard)"
 
 func _on_audio_backend_toggled(toggled_on: bool):
 	audio_backend = "stream" if toggled_on else "sles"
@@ -1096,6 +1102,9 @@ func _on_integer_scaling_toggled(toggled_on: bool):
 	if arranger:
 		arranger.dirty = true
 
+func _on_smooth_pacing_toggled(toggled_on: bool):
+	PicoVideoStreamer.set_frame_pacing_mode(PicoVideoStreamer.FramePacing.SMOOTH if toggled_on else PicoVideoStreamer.FramePacing.LOWEST_LATENCY)
+
 func _on_show_controls_selected(index: int):
 	PicoVideoStreamer.set_controls_mode(index)
 	# Force Arranger update
@@ -1272,6 +1281,7 @@ func save_config() -> void:
 	PicoBootManager.set_setting("settings", "swap_zx_enabled", PicoVideoStreamer.get_swap_zx_enabled())
 	PicoBootManager.set_setting("settings", "trackpad_sensitivity", PicoVideoStreamer.get_trackpad_sensitivity())
 	PicoBootManager.set_setting("settings", "integer_scaling_enabled", PicoVideoStreamer.get_integer_scaling_enabled())
+	PicoBootManager.set_setting("settings", "frame_pacing_mode", PicoVideoStreamer.get_frame_pacing_mode())
 	PicoBootManager.set_setting("settings", "bezel_enabled", PicoVideoStreamer.get_bezel_enabled())
 	
 	# Save Controls Mode (Integer)
@@ -1323,6 +1333,7 @@ func load_config():
 	var swap_zx = PicoBootManager.get_setting("settings", "swap_zx_enabled", false)
 	var sensitivity = PicoBootManager.get_setting("settings", "trackpad_sensitivity", 0.5)
 	var integer_scaling = PicoBootManager.get_setting("settings", "integer_scaling_enabled", true)
+	var frame_pacing_mode = PicoBootManager.get_setting("settings", "frame_pacing_mode", PicoVideoStreamer.FramePacing.LOWEST_LATENCY)
 	var bezel = PicoBootManager.get_setting("settings", "bezel_enabled", false)
 	
 	# Load Controls Mode with Migration
@@ -1449,6 +1460,7 @@ func load_config():
 	PicoVideoStreamer.set_swap_zx_enabled(swap_zx)
 	PicoVideoStreamer.set_trackpad_sensitivity(sensitivity)
 	PicoVideoStreamer.set_integer_scaling_enabled(integer_scaling)
+	PicoVideoStreamer.set_frame_pacing_mode(frame_pacing_mode)
 	PicoVideoStreamer.set_bezel_enabled(bezel)
 	PicoVideoStreamer.set_controls_mode(controls_mode)
 	PicoVideoStreamer.set_shader_type(shader_type)
@@ -1470,6 +1482,7 @@ func load_config():
 	if %ToggleHaptic: %ToggleHaptic.set_pressed_no_signal(haptic)
 	if %ToggleSwapZX: %ToggleSwapZX.set_pressed_no_signal(swap_zx)
 	if %ToggleIntegerScaling: %ToggleIntegerScaling.set_pressed_no_signal(integer_scaling)
+	if %ToggleSmoothPacing: %ToggleSmoothPacing.set_pressed_no_signal(frame_pacing_mode == PicoVideoStreamer.FramePacing.SMOOTH)
 	if %ToggleBezel: %ToggleBezel.set_pressed_no_signal(bezel)
 	if %ToggleReposition: %ToggleReposition.set_pressed_no_signal(PicoVideoStreamer.display_drag_enabled) # logic check?
 	if %OptionShowControls: %OptionShowControls.select(controls_mode)
@@ -1,10 +1,7 @@
 extends SceneTree
 
-# Default files to process if no arguments provided
-const DEFAULT_FILES = [
-	"F:/Dev/pico8-android/test-data/kalikan.p8.png",
-	"F:/Dev/pico8-android/test-data/wip.pip.png"
-]
+# Debug extractor: also dumps .bin/.ram.bin/.lua next to each cart.
+# For converting many carts use the native shim/cartdec (same .p8 content, parallel, see shim/BUILD.md).
 
 func _init():
 	print("--- Starting PICO-8 PNG Extraction ---")
@@ -30,14 +27,13 @@ func _init():
 				abs_path = ProjectSettings.globalize_path("res://" + abs_path)
 			files_to_process.append(abs_path)
 	
-	# Use default files if no arguments provided
 	if files_to_process.is_empty():
-		print("No files specified, using defaults")
-		files_to_process = DEFAULT_FILES
-	else:
-		print("Processing %d file(s) from arguments:" % files_to_process.size())
-		for f in files_to_process:
-			print("  - " + f)
+		print("Usage: godot --headless --script pico_extractor.gd <cart.p8.png>...")
+		quit(1)
+		return
+	print("Processing %d file(s) from arguments:" % files_to_process.size())
+	for f in files_to_process:
+		print("  - " + f)
 	
 	for path in files_to_process:
 		process_file(path)
@@ -107,6 +107,7 @@ func _on_applinks_data_received(data: String) -> void:
 	print("Restart Sequence Initiated for: ", pending_restart_path)
 
 func _launch_pico8(target_path: String) -> void:
+	PicoBootManager.mark_boot_phase("launch")
 	# Ensure clean slate (in case force kill was needed or cold boot)
 	if pico_pid:
 		_kill_all_pico_processes()
@@ -114,9 +115,14 @@ func _launch_pico8(target_path: String) -> void:
 	
 	# Reset suspension state
 	is_process_suspended = false
+	if PicoVideoStreamer.instance:
+		PicoVideoStreamer.instance.pause_requested = false
 	
 	var pkg_path = PicoBootManager.APPDATA_FOLDER + "/package"
 	var env_setup = "export HOME=" + pkg_path + "; "
+	# Stream backend: the shim feeds AudioStreamer directly over tmp/pico8.aud (no PulseAudio)
+	if PicoBootManager.get_audio_backend() == "stream":
+		env_setup += "export PICO_AUDIO_DIRECT=1; "
 	var run_arg = " -splore"
 	var extra_bind_export = ""
 	var root_bind_export = ""
@@ -204,6 +210,7 @@ func _launch_pico8(target_path: String) -> void:
 		var poke_cmd = "cd " + pkg_path + "; " + \
 					  "(test -p tmp/pico8.vid && timeout 0.2s sh -c 'echo poke > tmp/pico8.vid' || true) & " + \
 					  "(test -p tmp/pico8.in && timeout 0.2s sh -c 'cat tmp/pico8.in > /dev/null' || true) & " + \
+					  "(test -p tmp/pico8.aud && timeout 0.2s sh -c ': > tmp/pico8.aud' || true) & " + \
 					  "(test -p tmp/xdgopen && timeout 0.2s sh -c 'echo poke > tmp/xdgopen' || true) &"
 		OS.create_process(PicoBootManager.BIN_PATH + "/sh", ["-c", poke_cmd])
 
@@ -216,6 +223,7 @@ func _launch_pico8(target_path: String) -> void:
 				print("Pipe Release Timeout! Proceeding anyway...")
 				break
 		print("Pipes released by Godot.")
+		PicoBootManager.mark_boot_phase("pipes released")
 	
 	_xdg_url_connection_allowed = false
 	print("URL Handler: Suspended connection attempts.")
@@ -225,9 +233,9 @@ func _launch_pico8(target_path: String) -> void:
 	# returns exit code 1 on this device, causing all pipes to fail to be created.
 	var mkfifo_cmd = "cd " + pkg_path + "; " + \
 					 "mkdir -p tmp; " + \
-					 "rm -f tmp/pico8.vid tmp/pico8.in tmp/xdgopen; " + \
-					 "mkfifo tmp/pico8.vid tmp/pico8.in tmp/xdgopen; " + \
-					 "chmod 666 tmp/pico8.vid tmp/pico8.in tmp/xdgopen"
+					 "rm -f tmp/pico8.vid tmp/pico8.in tmp/pico8.aud tmp/pico8.fb tmp/xdgopen; " + \
+					 "mkfifo tmp/pico8.vid tmp/pico8.in tmp/pico8.aud tmp/xdgopen; " + \
+					 "chmod 666 tmp/pico8.vid tmp/pico8.in tmp/pico8.aud tmp/xdgopen"
 	var pipe_res = []
 	var pipe_err = OS.execute(PicoBootManager.BIN_PATH + "/sh", ["-c", mkfifo_cmd], pipe_res)
 	print("Pipe recreation finished with exit code %d. Output: %s" % [pipe_err, pipe_res])
@@ -246,6 +254,7 @@ func _launch_pico8(target_path: String) -> void:
 		PicoBootManager.BIN_PATH + "/sh",
 		["-c", cmdline]
 	)
+	PicoBootManager.mark_boot_phase("proot spawn")
 	print("executing as pid " + str(pico_pid) + "\n" + cmdline)
 
 
@@ -478,56 +487,23 @@ func suspend_pico_process() -> void:
 	if not pico_pid or pico_pid <= 0 or is_process_suspended:
 		return
 	
-	if not OS.is_process_running(pico_pid):
+	if not OS.is_process_running(pico_pid) or not PicoVideoStreamer.instance:
 		return
 	
-	# Notify video streamer to pause timeout monitoring
-	if PicoVideoStreamer.instance:
-		PicoVideoStreamer.instance.is_pico_suspended = true
-	
-	# Suspend proot and pico8_64
-	# Note: NOT suspending pulseaudio to avoid audio state issues on resume
-	var suspend_cmd = "pkill -STOP proot; pkill -STOP pico8_64"
-	var result = OS.execute(
-		PicoBootManager.BIN_PATH + "/sh",
-		["-c", suspend_cmd],
-		[],
-		false
-	)
-	
-	if result == OK:
-		is_process_suspended = true
-		print("PICO-8 process tree suspended")
-	else:
-		print("Failed to suspend PICO-8 process tree")
+	# The shim parks PICO-8 at its next frame boundary and stops its audio (PulseAudio keeps running).
+	# PicoVideoStreamer.is_pico_suspended follows once the shim acks it.
+	PicoVideoStreamer.instance.send_control(PicoVideoStreamer.CTL_OP_PAUSE)
+	is_process_suspended = true
+	print("PICO-8 pause requested")
 
 func resume_pico_process() -> void:
 	# Only resume if we have a valid PID and process is currently suspended
 	if not pico_pid or pico_pid <= 0 or not is_process_suspended:
 		return
 	
-	if not OS.is_process_running(pico_pid):
-		is_process_suspended = false
+	is_process_suspended = false
+	if not OS.is_process_running(pico_pid) or not PicoVideoStreamer.instance:
 		return
 	
-	# Notify video streamer to resume timeout monitoring
-	if PicoVideoStreamer.instance:
-		PicoVideoStreamer.instance.is_pico_suspended = false
-		# Reset the timeout timer so we don't get false timeout immediately
-		PicoVideoStreamer.instance.last_message_time = Time.get_ticks_msec()
-	
-	# Resume proot and pico8_64
-	# Note: NOT resuming pulseaudio since we didn't suspend it
-	var resume_cmd = "pkill -CONT proot; pkill -CONT pico8_64"
-	var result = OS.execute(
-		PicoBootManager.BIN_PATH + "/sh",
-		["-c", resume_cmd],
-		[],
-		false
-	)
-	
-	if result == OK:
-		is_process_suspended = false
-		print("PICO-8 process tree resumed")
-	else:
-		print("Failed to resume PICO-8 process tree")
+	PicoVideoStreamer.instance.send_control(PicoVideoStreamer.CTL_OP_RESUME)
+	print("PICO-8 resume requested")
@@ -114,12 +114,12 @@ func _instantiate_item(_item_data, _index: int) -> Control:
 		item_node.item_action.connect(_on_item_action)
 	return item_node
 
-func _set_item_background(item_data) -> void:
-	var thumb = item_data.get("thumbnail", null) if item_data is Dictionary else null
-	if thumb is ImageTexture and background_art:
-		background_art.texture = thumb
-	elif background_art:
-		background_art.texture = null
+# Online results were stored in ThumbnailCache while their page was decoded, local carts are decoded on demand
+func _get_thumbnail_key(item_data) -> String:
+	return item_data.get("thumb_key", "") if item_data is Dictionary else ""
+
+func _get_background_image_path(item_data) -> String:
+	return item_data.get("thumb_source", "") if item_data is Dictionary else ""
 
 func _apply_subclass_static_focus():
 	# Horizontal Search navigation
@@ -183,6 +183,7 @@ var _current_username: String = ""
 var _current_type: String = ""
 var _current_offset: int = 0
 const PAGE_SIZE: int = 32
+const LOCAL_CART_LIMIT: int = 50
 const BBS_BASE_URL = "https://www.lexaloffle.com/bbs/cpost_lister3.php"
 
 func _on_search_pressed():
@@ -242,17 +243,26 @@ var _is_loading_more: bool = false
 var _network_load_more_btn: Button = null
 
 func _on_request_completed(result: int, response_code: int, _headers: PackedStringArray, body: PackedByteArray):
-	btn_search.disabled = false
-	btn_search.text = "🔍"
-
 	if result != HTTPRequest.RESULT_SUCCESS or response_code != 200:
+		btn_search.disabled = false
+		btn_search.text = "🔍"
 		printerr("BBS request failed. Result: %d, HTTP: %d" % [result, response_code])
 		return
 
 	print("Response received: %d bytes" % body.size())
 
+	# The button stays busy until the page is decoded
+	WorkerThreadPool.add_task(_worker_decode_page.bind(body))
+
+func _worker_decode_page(body: PackedByteArray):
+	var start = Time.get_ticks_usec()
 	var carts = _decode_splore_png(body)
-	print("Decoded %d carts" % carts.size())
+	print("Decoded %d carts in %d ms" % [carts.size(), (Time.get_ticks_usec() - start) / 1000])
+	call_deferred("_finalize_page", carts)
+
+func _finalize_page(carts: Array):
+	btn_search.disabled = false
+	btn_search.text = "🔍"
 	for c in carts:
 		print("  - %s by %s [post:%s]" % [c.get("title", "?"), c.get("author", "?"), c.get("post_id", "?")])
 
@@ -322,7 +332,7 @@ func _on_network_load_more_pressed():
 
 
 func _load_local_bbs_carts():
-	print("Loading local BBS carts via busybox...")
+	print("Loading local BBS carts from the cart index...")
 	btn_search.disabled = true
 	btn_search.text = "⏳"
 
@@ -330,148 +340,120 @@ func _load_local_bbs_carts():
 	list_container.get_children().map(func(c): c.queue_free())
 	current_items.clear()
 
-	# Start background thread to avoid blocking UI during OS.execute
+	# Loading and refreshing the index touch the disk, keep them off the UI thread
 	WorkerThreadPool.add_task(_worker_load_local_carts.bind())
 
 func _worker_load_local_carts():
-	var bbs_path = MetadataCache.get_pico8_data_path()
-	
-	# Fallback if no busybox (e.g., Windows test environment)
-	if OS.get_name() == "Windows":
-		call_deferred("_finalize_local_carts_load", [])
-		return
-		
-	# Command: ls -1t /path/to/bbs/*/*.nfo | head -n 100
-	# We use the system sh to expand the wildcards correctly.
-	var cmd = "ls -1t " + bbs_path + "*/*.nfo | head -n 100"
-	print("Executing simple query: ", cmd)
-	
-	var output = []
-	var exit_code = OS.execute("/system/bin/sh", ["-c", cmd], output)
-	
-	print("Query finished with exit code %d." % exit_code)
-	
-	if exit_code != 0 or output.is_empty() or output[0].is_empty():
-		print("Simple query returned no results.")
-		call_deferred("_finalize_local_carts_load", [])
-		return
-		
-	var files = Array(output[0].split("\n"))
-	# Filter out empty strings
-	files = files.filter(func(f): return not f.strip_edges().is_empty())
-	
-	# Safety sort in case system ls -t behaves unexpectedly across multiple globs
-	#files.sort_custom(func(a, b):
-	#	return FileAccess.get_modified_time(a) > FileAccess.get_modified_time(b)
-	#)
-	
-	var unique_basenames = {}
-	var selected_paths = []
-	
-	for file in files:
-		file = file.strip_edges()
-		if file.is_empty(): continue
-		
-		# Deduplication logic
-		var filename = file.get_file()
-		var basename = filename.trim_suffix(".nfo")
-		if basename.begins_with("temp-"):
-			basename = basename.trim_prefix("temp-")
-			
-		if not unique_basenames.has(basename):
-			unique_basenames[basename] = true
-			selected_paths.append(file)
-			
-			if selected_paths.size() >= 50:
-				break
-				
-	# Back to main thread to populate UI
-	call_deferred("_finalize_local_carts_load", selected_paths)
-
-func _finalize_local_carts_load(nfo_paths: Array):
+	# Show the indexed list right away; the incremental rescan only redraws it if something changed
+	CartIndex.ensure_loaded()
+	call_deferred("_finalize_local_carts_load", CartIndex.query(CartIndex.Sort.RECENT, LOCAL_CART_LIMIT))
+	if CartIndex.refresh():
+		call_deferred("_finalize_local_carts_load", CartIndex.query(CartIndex.Sort.RECENT, LOCAL_CART_LIMIT))
+
+func _finalize_local_carts_load(entries: Array):
+	if not _current_username.is_empty():
+		return # An online search replaced the local list meanwhile
 	var carts = []
-	for path in nfo_paths:
-		var nfo_data = MetadataCache._parse_nfo(path)
-		if nfo_data.is_empty(): continue
-		
+	for entry in entries:
 		var cart = {
-			"post_id": nfo_data.get("lid", ""),
-			"title": nfo_data.get("title", "Unknown"),
-			"author": nfo_data.get("author", "Unknown"),
-			"basename": nfo_data.get("mid", ""), # Usually mid
-			"target_path": path # Save path just in case
+			"post_id": _nfo_field(entry, "lid", ""),
+			"title": _nfo_field(entry, "title", "Unknown"),
+			"author": _nfo_field(entry, "author", "Unknown"),
+			"basename": _nfo_field(entry, "mid", ""), # Usually mid
+			"target_path": entry.nfo, # Save path just in case
+			# Cart image located by the index: same folder, [lid].p8.png. Decoded when first focused.
+			"thumb_key": ThumbnailCache.key(_nfo_field(entry, "lid", entry.id), _nfo_field(entry, "mid", "")),
+			"thumb_source": entry.png
 		}
-		
-		# Look for thumbnail: same folder, [lid].p8.png
-		if not cart["post_id"].is_empty():
-			var dir_path = path.get_base_dir()
-			var png_path
-			if cart["basename"].is_valid_int() and not cart["post_id"].is_valid_int():
-				png_path = dir_path.path_join(cart["basename"] + ".p8.png")
-			else:
-				png_path = dir_path.path_join(cart["post_id"] + ".p8.png")
-			if FileAccess.file_exists(png_path):
-				var img = Image.new()
-				if img.load(png_path) == OK:
-					cart["thumbnail"] = ImageTexture.create_from_image(img)
-					
 		carts.append(cart)
-		
+
 	_all_items = carts
 	_current_offset = carts.size()
-	
+
 	btn_search.disabled = false
 	btn_search.text = "🔍"
 	_load_data()
 
+func _nfo_field(entry: Dictionary, field: String, fallback: String) -> String:
+	var value = entry.get(field)
+	return fallback if value == null else str(value)
+
 
 # ---- Steganography Decoder ----
 # The Splore PNG is a 1024x(N*136) image:
 #   - 8 columns of 128px-wide cart thumbnails
 #   - Each row is 136px tall: 128px thumb + 8px metadata strip below
 #   - The metadata strip encodes ASCII chars in the green channel (one char per pixel column)
+# Worker thread: cells are decoded in parallel straight from the RGBA8 bytes, and their thumbnails go to
+# ThumbnailCache instead of becoming textures up front.
+const SPLORE_COLUMNS = 8
+const SPLORE_CELL_HEIGHT = 136
+
 func _decode_splore_png(body: PackedByteArray) -> Array:
 	var img = Image.new()
 	var err = img.load_png_from_buffer(body)
 	if err != OK:
 		printerr("Failed to parse PNG response: ", err)
 		return []
+	if img.get_format() != Image.FORMAT_RGBA8:
+		img.convert(Image.FORMAT_RGBA8)
 
 	print("PNG size: %dx%d" % [img.get_width(), img.get_height()])
 
-	var carts: Array = []
-	var num_rows: int = int(img.get_height() / 136.0) # 128 thumb + 8 metadata strip per row
-
-	for row in range(num_rows):
-		for col in range(8):
-			var thumb_x = col * 128
-			var thumb_y = row * 136
-			var metadata_y = thumb_y + 128
-
-			# Read all 5 meaningful rows from the 8px metadata strip (green channel)
-			var strip_rows: Array[String] = []
-			for r in range(5):
-				var raw_chars: PackedByteArray = []
-				for px in range(128):
-					var char_val = img.get_pixel(thumb_x + px, metadata_y + r).g8
-					if char_val == 0:
-						break
-					raw_chars.append(char_val)
-				strip_rows.append(raw_chars.get_string_from_utf8().strip_edges())
-
-			if strip_rows[0].is_empty():
-				continue # No data = end of results
-
-			var cart = _parse_metadata(strip_rows)
-
-			# Crop the 128x128 thumbnail and store as ImageTexture (keeps it alive)
-			var thumb_img = img.get_region(Rect2i(thumb_x, thumb_y, 128, 128))
-			cart["thumbnail"] = ImageTexture.create_from_image(thumb_img)
+	var num_rows: int = int(img.get_height() / float(SPLORE_CELL_HEIGHT))
+	var cells: Array = []
+	cells.resize(num_rows * SPLORE_COLUMNS)
+	if cells.is_empty():
+		return []
+	var page = {"data": img.get_data(), "width": img.get_width(), "cells": cells, "mutex": Mutex.new()}
+	var group = WorkerThreadPool.add_group_task(_decode_splore_cell.bind(page), cells.size())
+	WorkerThreadPool.wait_for_group_task_completion(group)
 
+	# Cells stay in page order; cells past the end of the results stay null
+	var carts: Array = []
+	for cart in cells:
+		if cart != null:
 			carts.append(cart)
-
 	return carts
 
+func _decode_splore_cell(index: int, page: Dictionary):
+	var data: PackedByteArray = page.data
+	var stride: int = page.width * 4
+	var thumb_x = (index % SPLORE_COLUMNS) * 128
+	var thumb_y = floori(index / float(SPLORE_COLUMNS)) * SPLORE_CELL_HEIGHT
+	var metadata_y = thumb_y + 128
+
+	# Read all 5 meaningful rows from the 8px metadata strip (green channel)
+	var strip_rows: Array[String] = []
+	for r in range(5):
+		var raw_chars := PackedByteArray()
+		var offset = (metadata_y + r) * stride + thumb_x * 4 + 1
+		for px in range(128):
+			var char_val = data[offset + px * 4]
+			if char_val == 0:
+				break
+			raw_chars.append(char_val)
+		strip_rows.append(raw_chars.get_string_from_utf8().strip_edges())
+
+	if strip_rows[0].is_empty():
+		return # No data = end of results
+
+	var cart = _parse_metadata(strip_rows)
+	cart["thumb_key"] = ThumbnailCache.key(cart.get("post_id", ""), cart.get("filename", ""))
+
+	# Copy the 128x128 thumbnail out row by row, unless this version is cached already (page seen before)
+	if not ThumbnailCache.has(cart.thumb_key):
+		var pixels := PackedByteArray()
+		for y in range(128):
+			var row_start = (thumb_y + y) * stride + thumb_x * 4
+			pixels.append_array(data.slice(row_start, row_start + 128 * 4))
+		var thumb = Image.create_from_data(128, 128, false, Image.FORMAT_RGBA8, pixels)
+		ThumbnailCache.put_image(cart.thumb_key, thumb)
+
+	page.mutex.lock()
+	page.cells[index] = cart
+	page.mutex.unlock()
+
 # Strip row layout (green channel):
 #   Row 0: "cat_id post_id subcat_id score replies datetime"
 #   Row 1: title
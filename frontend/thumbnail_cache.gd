@@ -0,0 +1,218 @@
+class_name ThumbnailCache
+extends RefCounted
+
+# Cart label thumbnails (128x128) shared by the Splore, favourites and stats screens, keyed by cart id and
+# version so a cart is decoded once no matter which screen or source it came from:
+#   - Splore result pages store the labels they carry (carts that were never downloaded included)
+#   - local .p8.png carts are decoded and cropped to CartIndex.LABEL_RECT on first use
+# On disk: CACHE_DIR/<key>.png, trimmed back to DISK_TRIM_RATIO of MAX_DISK_BYTES, least recently used
+# first, when it grows past it. Use times only live in memory, after a restart it is oldest written first.
+# In memory: the last MAX_MEMORY_IMAGES images, most recently used last.
+
+const CACHE_DIR = "user://thumbnails"
+const MAX_DISK_BYTES = 16 * 1024 * 1024
+const DISK_TRIM_RATIO = 0.75
+const MAX_MEMORY_IMAGES = 256
+const THUMB_SIZE = Vector2i(128, 128)
+const CART_IMAGE_SIZE = Vector2i(160, 205)
+
+# _mutex guards everything below; disk reads, directory listing and PNG decoding happen outside it
+static var _mutex := Mutex.new()
+static var _memory: Dictionary = {} # key -> Image
+static var _disk: Dictionary = {} # key -> {size, used}
+static var _disk_bytes := 0
+static var _scanned := false
+static var _use_counter := 0
+# Main thread only: key -> callbacks waiting for a worker
+static var _in_flight: Dictionary = {}
+
+static func key(id: String, version: String = "") -> String:
+	# Splore and the .nfo files name versions "name-3", stats keep the file name ("name-3.p8.png")
+	version = version.get_file().trim_suffix(".png").trim_suffix(".p8")
+	var raw = id if version.is_empty() else "%s@%s" % [id, version]
+	return raw.validate_filename()
+
+# Memory only, never blocks: null if the image isn't loaded yet
+static func peek(cache_key: String) -> Image:
+	_mutex.lock()
+	var img = _touch_memory(cache_key)
+	_mutex.unlock()
+	return img
+
+# In memory or on disk, without loading it. Any thread (the first call lists the directory).
+static func has(cache_key: String) -> bool:
+	_scan()
+	_mutex.lock()
+	var found = _memory.has(cache_key) or _disk.has(cache_key)
+	_mutex.unlock()
+	return found
+
+# Memory, then disk. Worker thread, null if not cached.
+static func get_image(cache_key: String) -> Image:
+	var img = peek(cache_key)
+	if img:
+		return img
+	_scan()
+	_mutex.lock()
+	var on_disk = _disk.has(cache_key)
+	_mutex.unlock()
+	if not on_disk:
+		return null
+	img = Image.load_from_file(_path(cache_key))
+	_mutex.lock()
+	if img:
+		_disk[cache_key].used = _next_use()
+		_remember(cache_key, img)
+	else:
+		_forget_disk(cache_key) # Deleted or torn behind our back
+	_mutex.unlock()
+	return img
+
+# Worker thread. Written to a temporary file first so a reader never sees half a PNG.
+static func put_image(cache_key: String, img: Image):
+	if img.get_format() != Image.FORMAT_RGB8:
+		img = img.duplicate()
+		img.convert(Image.FORMAT_RGB8)
+	_scan()
+	_mutex.lock()
+	_remember(cache_key, img)
+	_mutex.unlock()
+
+	var path = _path(cache_key)
+	var tmp_path = path + ".tmp%d" % OS.get_thread_caller_id()
+	if img.save_png(tmp_path) != OK:
+		printerr("ThumbnailCache: Could not write ", tmp_path)
+		return
+	var f = FileAccess.open(tmp_path, FileAccess.READ)
+	var size = f.get_length() if f else 0
+	f = null
+	var err = DirAccess.rename_absolute(ProjectSettings.globalize_path(tmp_path), ProjectSettings.globalize_path(path))
+	if err != OK:
+		printerr("ThumbnailCache: Could not store %s (error %d)" % [cache_key, err])
+		DirAccess.remove_absolute(ProjectSettings.globalize_path(tmp_path))
+		return
+	_mutex.lock()
+	_forget_disk(cache_key)
+	_disk[cache_key] = {"size": size, "used": _next_use()}
+	_disk_bytes += size
+	if _disk_bytes > MAX_DISK_BYTES:
+		_trim_disk()
+	_mutex.unlock()
+
+# The cached label, or the one decoded from source_path (a .p8.png or another PNG). Worker thread.
+static func load_label(cache_key: String, source_path: String) -> Image:
+	var img = get_image(cache_key)
+	if img or not source_path.ends_with(".png") or not FileAccess.file_exists(source_path):
+		return img
+	img = Image.load_from_file(source_path)
+	if img == null:
+		return null
+	if img.get_size() == CART_IMAGE_SIZE:
+		img = img.get_region(CartIndex.LABEL_RECT)
+	elif img.get_size() != THUMB_SIZE:
+		img.resize(THUMB_SIZE.x, THUMB_SIZE.y, Image.INTERPOLATE_NEAREST)
+	put_image(cache_key, img)
+	return img
+
+# Main thread. callback(cache_key, image_or_null) is called right away if the image is in memory,
+# otherwise on the main thread once a worker has it. Concurrent requests for one key share the work.
+static func request(cache_key: String, source_path: String, callback: Callable):
+	var img = peek(cache_key)
+	if img:
+		callback.call(cache_key, img)
+		return
+	if _in_flight.has(cache_key):
+		_in_flight[cache_key].append(callback)
+		return
+	_in_flight[cache_key] = [callback]
+	WorkerThreadPool.add_task(_worker_request.bind(cache_key, source_path))
+
+static func _worker_request(cache_key: String, source_path: String):
+	var img = load_label(cache_key, source_path)
+	_deliver.call_deferred(cache_key, img)
+
+static func _deliver(cache_key: String, img: Image):
+	for callback in _in_flight.get(cache_key, []):
+		if callback.is_valid():
+			callback.call(cache_key, img)
+	_in_flight.erase(cache_key)
+
+static func _path(cache_key: String) -> String:
+	return CACHE_DIR.path_join(cache_key + ".png")
+
+# Caller holds _mutex
+static func _next_use() -> int:
+	_use_counter += 1
+	return _use_counter
+
+# Caller holds _mutex
+static func _touch_memory(cache_key: String) -> Image:
+	var img = _memory.get(cache_key)
+	if img != null:
+		# Re-insert to move it to the back of the eviction order
+		_memory.erase(cache_key)
+		_memory[cache_key] = img
+		if _disk.has(cache_key):
+			_disk[cache_key].used = _next_use()
+	return img
+
+# Caller holds _mutex
+static func _remember(cache_key: String, img: Image):
+	_memory.erase(cache_key)
+	_memory[cache_key] = img
+	while _memory.size() > MAX_MEMORY_IMAGES:
+		_memory.erase(_memory.keys()[0])
+
+# Caller holds _mutex
+static func _forget_disk(cache_key: String):
+	if _disk.has(cache_key):
+		_disk_bytes -= int(_disk[cache_key].size)
+		_disk.erase(cache_key)
+
+# The directory is listed once per run, without _mutex: only the merge takes it. Callers racing the first
+# listing each do their own and the first merge wins. Only the winner sweeps temporaries, from its own
+# listing: it was taken before any put_image() (which scans first) could write one.
+static func _scan():
+	_mutex.lock()
+	var scanned = _scanned
+	_mutex.unlock()
+	if scanned:
+		return
+	if not DirAccess.dir_exists_absolute(CACHE_DIR):
+		DirAccess.make_dir_recursive_absolute(CACHE_DIR)
+	var files = []
+	var temporaries = []
+	for fname in DirAccess.get_files_at(CACHE_DIR):
+		var path = CACHE_DIR.path_join(fname)
+		if not fname.ends_with(".png"):
+			temporaries.append(path) # From a crash
+			continue
+		files.append({"key": fname.trim_suffix(".png"), "size": FileAccess.get_size(path), "mtime": FileAccess.get_modified_time(path)})
+	files.sort_custom(func(a, b): return a.mtime < b.mtime)
+
+	_mutex.lock()
+	var won = not _scanned
+	if won:
+		_scanned = true
+		for file in files:
+			if not _disk.has(file.key):
+				_disk[file.key] = {"size": file.size, "used": _next_use()}
+				_disk_bytes += file.size
+	_mutex.unlock()
+	if won:
+		for path in temporaries:
+			DirAccess.remove_absolute(ProjectSettings.globalize_path(path))
+		print("ThumbnailCache: %d thumbnails on disk (%d KB)" % [files.size(), _disk_bytes / 1024])
+
+# Caller holds _mutex
+static func _trim_disk():
+	var keys = _disk.keys()
+	keys.sort_custom(func(a, b): return _disk[a].used < _disk[b].used)
+	var removed = 0
+	for cache_key in keys:
+		if _disk_bytes <= MAX_DISK_BYTES * DISK_TRIM_RATIO:
+			break
+		DirAccess.remove_absolute(ProjectSettings.globalize_path(_path(cache_key)))
+		_forget_disk(cache_key)
+		removed += 1
+	print("ThumbnailCache: Evicted %d thumbnails, %d KB left" % [removed, _disk_bytes / 1024])
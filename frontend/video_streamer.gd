@@ -13,6 +13,7 @@ signal controls_mode_changed(mode: int)
 
 var PIPE_VID = PicoBootManager.APPDATA_FOLDER + "/package/tmp/pico8.vid"
 var PIPE_IN = PicoBootManager.APPDATA_FOLDER + "/package/tmp/pico8.in"
+var PIPE_FB = PicoBootManager.APPDATA_FOLDER + "/package/tmp/pico8.fb" # Shared frame ring (regular file)
 
 # Pipe Handles
 var vid_pipe_id: int = -1
@@ -29,10 +30,54 @@ var _input_queue: Array = []
 var _main_thread_input_buffer: Array = []
 var _pipe_reset_complete: bool = true
 var _connection_allowed: bool = false
+# pipe_open retry delay: starts short (the FIFOs usually appear within a few ms of a launch), doubles up to the max
+const PIPE_RETRY_MIN_MS = 10
+const PIPE_RETRY_MAX_MS = 500
+var _pipe_retry_ms: int = PIPE_RETRY_MIN_MS
 
 const PIDOT_EVENT_MOUSEEV = 1;
 const PIDOT_EVENT_KEYEV = 2;
 const PIDOT_EVENT_CHAREV = 3;
+const PIDOT_EVENT_VIDMODE = 4;
+const PIDOT_EVENT_SNAPSHOT = 5;
+const PIDOT_EVENT_CONTROL = 6;
+
+# Snapshot ops (PIDOT_EVENT_SNAPSHOT), carried out by the shim at the next frame
+const SNAP_OP_SAVE = 0 # Park a copy-on-write copy of PICO-8 in the slot
+const SNAP_OP_LOAD = 1 # Resume the slot's copy in place of the running one
+const SNAP_OP_DROP = 2
+const SNAP_OP_WRITE = 3 # RAM + changed pages to disk
+const SNAP_OP_READ = 4 # RAM back from disk
+# Control ops (PIDOT_EVENT_CONTROL), applied by the shim as soon as it reads them and acked with a PKT_CONTROL
+const CTL_OP_PAUSE = 0 # PICO-8 and its audio stop at the next frame boundary
+const CTL_OP_RESUME = 1
+const CTL_OP_FPS_CAP = 2 # Arg: frames per second, 0 = uncapped
+const CTL_OP_VIDEO = 3 # Arg 0: the game keeps running without sending frames, 1: frames again
+const CTL_FLAG_PAUSED = 0x01
+const CTL_FLAG_VIDEO_OFF = 0x02
+var _control_token: int = 0
+var pause_requested: bool = false # Between CTL_OP_PAUSE and CTL_OP_RESUME (read by AudioStreamer's thread)
+# Last ack (pipe thread, under _mutex): token echoed back and the shim's state after it
+var control_acked_token: int = 0
+var shim_control_flags: int = 0
+var shim_fps_cap: int = 0
+
+# Keyboard quick-save / quick-load (Shift+key) into this slot
+const QUICK_SNAPSHOT_KEY = KEY_F5
+const QUICK_SNAPSHOT_SLOT = 0
+
+# Input packet on the wire: Event(8) + Seq(4) + Timestamp(4, wall clock usec mod 2^32)
+const IN_EVENT_BYTES = 8
+const IN_PACKET_SIZE = 16
+var _input_seq: int = 0
+
+# Video encodings negotiated with the shim (PIDOT_EVENT_VIDMODE)
+const VID_ENCODING_RGBA = 0
+const VID_ENCODING_INDEXED = 1
+const VID_FLAG_DELTA = 0x01 # Accept keepalive + dirty-row delta packets
+const VID_FLAG_SHM = 0x02 # Frames in the shared ring file, FIFO carries doorbells only
+var video_encoding: int = VID_ENCODING_INDEXED
+var video_flags: int = VID_FLAG_DELTA | VID_FLAG_SHM
 
 var _r1_held: bool = false
 var _r1_used_as_modifier: bool = false
@@ -54,7 +99,7 @@ var last_message_time: int = 0
 const RETRY_INTERVAL: int = 200
 const READ_TIMEOUT: int = 5000
 var is_intent_session: bool = false
-var is_pico_suspended: bool = false # Track if PICO-8 process is suspended
+var is_pico_suspended: bool = false # PICO-8 is paused, as last acked by the shim (CTL_FLAG_PAUSED)
 var advanced_features_enabled: bool = false
 var is_square: bool = false
 var _prev_has_devkit: bool = false
@@ -141,8 +186,8 @@ func _ready() -> void:
 	# Pre-calculate PackedByteArray for fast sync check
 	SYNC_SEQ_PBA = PackedByteArray(SYNC_SEQ)
 	
-	# Pre-allocate texture for performance (Triple Buffering)
-	for i in range(3):
+	# Pre-allocate texture for performance (Frame Queue)
+	for i in range(FRAME_BUFFER_COUNT):
 		var img = Image.create(128, 128, false, Image.FORMAT_RGBA8)
 		_buffer_images.append(img)
 		
@@ -270,9 +315,7 @@ func load_external_shader(shader_name: String) -> Shader:
 	return load(builtin_path)
 
 func _thread_function():
-	# Small initial delay to let shell script finish mkfifo
-	OS.delay_msec(200)
-		
+	# No startup delay: connections are held until _launch_pico8 has recreated the FIFOs
 	var buffer: PackedByteArray = PackedByteArray()
 	
 	while _thread_active:
@@ -288,6 +331,13 @@ func _thread_function():
 		if do_reset:
 			synched = false
 			buffer.clear()
+			_shm_file = null
+			if _mutex:
+				_mutex.lock()
+				_frame_queue.clear()
+				_last_capture_ts = -1
+				_transit_min_us = 0
+				_mutex.unlock()
 			
 			# Force clean reconnection of pipes (fixes Restart with FIFO)
 			if _applinks_plugin:
@@ -340,10 +390,14 @@ func _thread_function():
 					if pid != -1:
 						in_pipe_id = pid
 						print("Pipe: Connected to Input Pipe (ID: ", pid, ")")
+						# Negotiate packet encoding before anything else goes out
+						_mutex.lock()
+						_input_queue.push_front([PIDOT_EVENT_VIDMODE, video_encoding, video_flags, 0, 0, 0, 0, 0])
+						_mutex.unlock()
 					else:
 						# Open failed (not found?)
-						print("Pipe: Input Pipe connection failed, retrying...")
-						OS.delay_msec(500)
+						print("Pipe: Input Pipe connection failed, retrying in ", _pipe_retry_ms, " ms...")
+						_pipe_retry_backoff()
 
 				# Video Pipe
 				if vid_pipe_id == -1:
@@ -360,17 +414,17 @@ func _thread_function():
 						print("Pipe: Connected to Video Pipe (ID: ", pid, ")")
 					else:
 						# Open failed
-						print("Pipe: Video Pipe connection failed/blocked, retrying...")
-						OS.delay_msec(500)
+						print("Pipe: Video Pipe connection failed/blocked, retrying in ", _pipe_retry_ms, " ms...")
+						_pipe_retry_backoff()
 			
 			# Check connection status
 			var pipes_connected = (vid_pipe_id != -1 and in_pipe_id != -1)
 			
 			if not pipes_connected:
 				continue
+			_pipe_retry_ms = PIPE_RETRY_MIN_MS
 		
-		# Connected
-		loading.call_deferred("set_visible", false)
+		# Connected. The loading animation stays until the shim's ready packet (see PKT_READY)
 		
 		# 1. Send Inputs
 		_mutex.lock()
@@ -378,58 +432,87 @@ func _thread_function():
 		_input_queue.clear()
 		_mutex.unlock()
 		
-		if inputs.size() > 0:
+		if inputs.size() > 0 and _applinks_plugin:
+			# One pipe_write per batch; packets stamped on the main thread keep that timestamp
+			var batch = PackedByteArray()
+			batch.resize(inputs.size() * IN_PACKET_SIZE)
+			var now_ts = _input_timestamp()
+			var offset = 0
 			for packet in inputs:
-				var pba = PackedByteArray(packet)
-				if _applinks_plugin:
-					_applinks_plugin.pipe_write(in_pipe_id, pba)
+				for i in range(IN_EVENT_BYTES):
+					batch[offset + i] = packet[i]
+				_input_seq = (_input_seq + 1) & 0xFFFFFFFF
+				batch.encode_u32(offset + IN_EVENT_BYTES, _input_seq)
+				batch.encode_u32(offset + IN_EVENT_BYTES + 4, packet[IN_EVENT_BYTES] if packet.size() > IN_EVENT_BYTES else now_ts)
+				offset += IN_PACKET_SIZE
+			_applinks_plugin.pipe_write(in_pipe_id, batch)
 			
 		# 2. Read Video
 		var chunk: PackedByteArray
 		if _applinks_plugin:
-			chunk = _applinks_plugin.pipe_read(vid_pipe_id, TOTAL_PACKET_SIZE)
+			chunk = _applinks_plugin.pipe_read(vid_pipe_id, MAX_PACKET_SIZE)
 
 		if chunk.size() > 0:
-			buffer.append_array(chunk)
-			
-			# Header Sync Check
-			if not synched:
-				var syncpoint = find_seq_pba(buffer, SYNC_SEQ_PBA)
-				if syncpoint != -1:
-					if buffer.size() >= syncpoint + TOTAL_PACKET_SIZE:
-						var packet = buffer.slice(syncpoint, syncpoint + TOTAL_PACKET_SIZE)
-						_process_packet_thread(packet)
-						buffer = buffer.slice(syncpoint + TOTAL_PACKET_SIZE)
-						synched = true
-					else:
-						# Found sync point but packet is incomplete, wait for more data
-						if syncpoint > 0:
-							buffer = buffer.slice(syncpoint)
-				else:
-					# No sync point in current buffer
-					if buffer.size() > TOTAL_PACKET_SIZE * 2:
-						# Buffer is too large and no sync found, prune it
-						buffer = buffer.slice(TOTAL_PACKET_SIZE)
+			# Parse the chunk in place unless a partial packet is carried over from the last read
+			if buffer.is_empty():
+				buffer = chunk
 			else:
-				# Synched Mode - validate header at position 0
-				if buffer.size() >= TOTAL_PACKET_SIZE:
-					# Validate Header
-					var header_valid = true
-					# Fast checking using slice equality
-					if buffer.slice(0, SYNC_SEQ_PBA.size()) != SYNC_SEQ_PBA:
-						header_valid = false
-					
-					if header_valid:
-						var packet = buffer.slice(0, TOTAL_PACKET_SIZE)
-						_process_packet_thread(packet)
-						buffer = buffer.slice(TOTAL_PACKET_SIZE)
-					else:
-						# Header mismatch - lost sync, rescan
-						print("Pipe: Lost Sync! Rescanning...")
-						synched = false
+				buffer.append_array(chunk)
+			
+			# Packets are variable size (RGBA / Indexed), so drain every complete one
+			var pos = 0
+			while true:
+				# Header Sync Check
+				if not synched:
+					var syncpoint = find_seq_pba(buffer, SYNC_SEQ_PBA, pos)
+					if syncpoint == -1:
+						# Keep only a tail that could hold a partial sync sequence
+						pos = max(pos, buffer.size() - SYNC_SEQ_PBA.size() + 1)
+						break
+					pos = syncpoint
+					synched = true
+				
+				if buffer.size() - pos < PACKET_HEADER_BYTES:
+					break
+				
+				# Synched Mode - validate header at current position
+				var packet_size = -1
+				if _has_sync_at(buffer, pos):
+					packet_size = _packet_size(buffer, pos)
+				
+				if packet_size == -2:
+					# Delta row mask not fully received yet
+					break
+				
+				if packet_size == -1:
+					# Header mismatch or unknown type - lost sync, rescan
+					print("Pipe: Lost Sync! Rescanning...")
+					synched = false
+					pos += 1
+					continue
+				
+				if buffer.size() - pos < packet_size:
+					break
+				
+				_process_packet_thread(buffer, pos)
+				pos += packet_size
+			
+			# Only a partial packet is ever copied; a fully consumed chunk is just dropped
+			if pos >= buffer.size():
+				buffer = PackedByteArray()
+			elif pos > 0:
+				buffer = buffer.slice(pos)
 		else:
 			OS.delay_msec(1)
 
+func _pipe_retry_backoff():
+	OS.delay_msec(_pipe_retry_ms)
+	_pipe_retry_ms = mini(_pipe_retry_ms * 2, PIPE_RETRY_MAX_MS)
+
+# Wall clock in microseconds, truncated to 32 bits to match the shim's clock
+static func _input_timestamp() -> int:
+	return int(Time.get_unix_time_from_system() * 1000000.0) & 0xFFFFFFFF
+
 func reconnect_threaded():
 	pass # No-op for pipes
 
@@ -500,26 +583,108 @@ func release_input_locks():
 	DisplayServer.virtual_keyboard_hide()
 	Applinks.hide_keyboard()
 
-const SYNC_SEQ = [80, 73, 67, 79, 56, 83, 89, 78, 67, 95, 95] # "PICO8SYNC__"
+const SYNC_SEQ = [80, 73, 67, 79, 56, 83, 89, 78, 67] # "PICO8SYNC"
 #const SYNC_SEQ = [80, 73, 67, 79, 56, 83, 89] # "PICO8SY"
 var SYNC_SEQ_PBA: PackedByteArray
+const PACKET_TYPE_INDEX = 9 # "PICO8SYNC" + Type(1) + Reserved(1)
+const HEADER_BYTE_COUNT = 11
 const CUSTOM_BYTE_COUNT = 3
 #const CUSTOM_BYTE_COUNT = 5 # State(1) + Input(1) + Cart(1) + Editor(1) + NavState(1)
 var current_custom_data := range(CUSTOM_BYTE_COUNT)
+# FrameSeq(4) + CaptureTimestamp(4): shim present counter and wall clock usec mod 2^32 (same clock as input timestamps)
+const FRAME_INFO_BYTES = 8
+const FRAME_SEQ_INDEX = HEADER_BYTE_COUNT + CUSTOM_BYTE_COUNT
+const CAPTURE_TS_INDEX = FRAME_SEQ_INDEX + 4
+const PACKET_HEADER_BYTES = HEADER_BYTE_COUNT + CUSTOM_BYTE_COUNT + FRAME_INFO_BYTES
 const DISPLAY_BYTES = 128 * 128 * 4 # 64KB RGBA8888
-const TOTAL_PACKET_SIZE = len(SYNC_SEQ) + CUSTOM_BYTE_COUNT + DISPLAY_BYTES
-
+const PALETTE_BYTES = 16 * 3 # 16 x RGB
+const INDEXED_BYTES = 128 * 128 / 2 # 8KB, 4bpp (low nibble = left pixel)
+
+# Packet types (header byte 9)
+const PKT_RGBA = 95 # '_' (original "PICO8SYNC__" packet)
+const PKT_INDEXED = 73 # 'I'
+const PKT_KEEPALIVE = 75 # 'K' - frame unchanged, metadata only
+const PKT_RGBA_DELTA = 100 # 'd' - RowMask(16) + changed RGBA rows
+const PKT_INDEXED_DELTA = 105 # 'i' - Palette(48) + RowMask(16) + changed 4bpp rows
+const PKT_SHM_FRAME = 83 # 'S' - Slot(1) + Pad(3) + Seq(4), frame is in the shared ring
+const PKT_TELEMETRY = 84 # 'T' - Shim pipeline counters, about once a second
+const PKT_READY = 82 # 'R' - Boot phase timestamps, once per connection after the first frame
+const PKT_CONTROL = 67 # 'C' - Control ack: Token(1) + Flags(1) + FpsCap(1) + Pad(1) + PresentSeq(4), repeated while paused
+
+# Telemetry payload, u32 each: averages over the last window unless noted
+const TELEMETRY_BYTES = 32
+const TEL_QUEUE_US = 0 # Present -> sender thread picked it up
+const TEL_ENCODE_US = 1 # Diff + conversion / indexing
+const TEL_WRITE_US = 2 # Blocked in write() (FIFO full = reader behind)
+const TEL_WRITE_MAX_US = 3
+const TEL_DROPPED = 4 # Total
+const TEL_COALESCED = 5 # Total
+const TEL_POLL_RATE = 6 # SDL_PollEvent calls per second
+const TEL_SENT = 7 # Total
+
+# Ready payload, u32 each: shim boot phases on the wall clock (usec mod 2^32), 0 = not reached
+const READY_PHASES = ["shim load", "SDL_Init", "input FIFO", "video FIFO", "first frame"]
+const READY_BYTES = 4 * 5
+
+const CONTROL_BYTES = 8
+
+const ROW_MASK_BYTES = 16 # 1 bit per scanline, bit (y & 7) of byte (y >> 3)
+const RGBA_ROW_BYTES = 128 * 4
+const INDEXED_ROW_BYTES = 128 / 2
+
+# Shared ring file: "PICO8FB1" + SlotCount(4) + SlotSize(4), padded to 64 bytes.
+# Slot: Seq(4, odd while the shim writes) + PacketType(4) + Length(4) + Pad(4) + payload
+const SHM_MAGIC = "PICO8FB1"
+const SHM_HEADER_BYTES = 64
+const SHM_SLOT_HEADER_BYTES = 16
+const SHM_DOORBELL_BYTES = 8
+var _shm_file: FileAccess = null
+var _shm_slot_count: int = 0
+var _shm_slot_size: int = 0
+
+const TOTAL_PACKET_SIZE = PACKET_HEADER_BYTES + DISPLAY_BYTES
+const INDEXED_PACKET_SIZE = PACKET_HEADER_BYTES + PALETTE_BYTES + INDEXED_BYTES
+const MAX_PACKET_SIZE = TOTAL_PACKET_SIZE
+
+# Current full RGBA frame; indexed and delta packets are applied onto it (reader thread only)
+var _frame_rgba: PackedByteArray
+var _palette_lut: PackedInt32Array
+var _popcount: PackedByteArray
+
+# Decoded frames wait in a small timestamped queue until the pacing scheduler presents them.
+# The queue never holds more than FRAME_QUEUE_MAX buffers, so the reader's write head
+# (always the oldest buffer) can't be one that is still waiting.
+const FRAME_BUFFER_COUNT = 5
+const FRAME_QUEUE_MAX = 3
 var _buffer_images: Array[Image] = []
 var _write_head: int = 0
-var _ready_index: int = -1 # Index of the latest fully written frame
+var _frame_queue: Array[int] = [] # Buffer indices, oldest first (under _mutex)
 var _read_index: int = -1 # Index currently displayed
+# Per buffer: shim frame seq, capture -> read latency (usec), read time (ticks usec), capture timestamp (shim wall clock)
+var _buffer_frame_seq := PackedInt64Array([0, 0, 0, 0, 0])
+var _buffer_capture_us := PackedInt64Array([0, 0, 0, 0, 0])
+var _buffer_read_ticks := PackedInt64Array([0, 0, 0, 0, 0])
+var _buffer_capture_ts := PackedInt64Array([0, 0, 0, 0, 0])
+
+# Pacing model (reader thread updates, main thread reads, under _mutex):
+# transit = capture -> read latency. Its recent minimum is the clock offset between the
+# shim's capture timestamps and our arrival times; the spread above it is the jitter to absorb.
+const TRANSIT_WINDOW_FRAMES = 120
+const PACING_MAX_DELAY_US = 50000
+var _transit_min_us: int = 0
+var _transit_window_min_us: int = 0x7FFFFFFF
+var _transit_window_count: int = 0
+var _transit_jitter_us: float = 0.0
+var _source_period_us: float = 16667.0
+var _last_capture_ts: int = -1
+var pacing_frames_dropped: int = 0 # Queued frames never presented (under _mutex)
 var fps_timer: float = 0.0
 var fps_frame_count: int = 0
 var fps_skip_count: int = 0
 var debug_fps_label: Label = null
 
 # Thread-safe image update using Ring Buffer (Triple Buffering - Pull Model)
-func set_im_from_data_threaded(rgba: PackedByteArray):
+func set_im_from_data_threaded(rgba: PackedByteArray, frame_seq: int = 0, capture_to_read_us: int = 0, capture_ts: int = 0):
 	# Select buffer to write to
 	var write_idx = _write_head
 	var img = _buffer_images[write_idx]
@@ -541,14 +706,80 @@ func set_im_from_data_threaded(rgba: PackedByteArray):
 	# Mark as ready
 	if _mutex:
 		_mutex.lock()
-		_ready_index = write_idx
+		_buffer_frame_seq[write_idx] = frame_seq
+		_buffer_capture_us[write_idx] = capture_to_read_us
+		_buffer_read_ticks[write_idx] = Time.get_ticks_usec()
+		_buffer_capture_ts[write_idx] = capture_ts
+		_update_pacing_model(capture_to_read_us, capture_ts)
+		_frame_queue.append(write_idx)
+		if _frame_queue.size() > FRAME_QUEUE_MAX:
+			_frame_queue.pop_front()
+			pacing_frames_dropped += 1
 		fps_frame_count += 1
 		_mutex.unlock()
 	
-	# Advance head (Ring Buffer 0 -> 1 -> 2 -> 0)
-	_write_head = (_write_head + 1) % 3
-
-func find_seq_pba(host: PackedByteArray, sub: PackedByteArray) -> int:
+	# Advance head (Ring Buffer 0 -> 1 -> ... -> FRAME_BUFFER_COUNT - 1 -> 0)
+	_write_head = (_write_head + 1) % FRAME_BUFFER_COUNT
+
+# Called with _mutex held
+func _update_pacing_model(transit_us: int, capture_ts: int):
+	_transit_window_min_us = min(_transit_window_min_us, transit_us)
+	_transit_window_count += 1
+	if _transit_min_us == 0 or transit_us < _transit_min_us:
+		_transit_min_us = transit_us
+	if _transit_window_count >= TRANSIT_WINDOW_FRAMES:
+		# Let the offset drift back up if the clocks or the path changed
+		_transit_min_us = _transit_window_min_us
+		_transit_window_min_us = 0x7FFFFFFF
+		_transit_window_count = 0
+	_transit_jitter_us += ((transit_us - _transit_min_us) - _transit_jitter_us) / 16.0
+	
+	# Source cadence from capture timestamps. Unchanged frames are never sent, so only
+	# take gaps that look like one frame (<= 40ms) into the estimate.
+	if _last_capture_ts >= 0:
+		var gap = (capture_ts - _last_capture_ts) & 0xFFFFFFFF
+		if gap > 0 and gap <= 40000:
+			_source_period_us += (gap - _source_period_us) / 16.0
+	_last_capture_ts = capture_ts
+
+# Pick the queued frame to show at this vsync, or -1 to keep the current one.
+# Lowest latency: always the newest. Smooth: the newest frame whose capture time plus a
+# fixed delay has passed, so frames come out on the source cadence instead of arrival jitter.
+func _select_frame_to_present() -> int:
+	if not _mutex:
+		return -1
+	_mutex.lock()
+	var chosen = -1
+	var dropped = 0
+	if not _frame_queue.is_empty():
+		if frame_pacing_mode == FramePacing.LOWEST_LATENCY:
+			chosen = _frame_queue.back()
+			dropped = _frame_queue.size() - 1
+			_frame_queue.clear()
+		else:
+			var refresh = DisplayServer.screen_get_refresh_rate()
+			var vsync_us = 1000000.0 / (refresh if refresh > 0 else 60.0)
+			# Hold back enough to cover the jitter, at least half a vsync, at most one source frame
+			var delay_us = clamp(2.0 * _transit_jitter_us, vsync_us / 2.0, max(vsync_us / 2.0, _source_period_us))
+			var present_age_us = min(_transit_min_us + delay_us, PACING_MAX_DELAY_US) - vsync_us / 2.0
+			var now_ts = _input_timestamp()
+			var due = 0
+			for idx in _frame_queue:
+				if ((now_ts - _buffer_capture_ts[idx]) & 0xFFFFFFFF) >= present_age_us:
+					due += 1
+			# A full queue means the schedule fell behind: show the oldest rather than stall
+			if due == 0 and _frame_queue.size() >= FRAME_QUEUE_MAX:
+				due = 1
+			if due > 0:
+				chosen = _frame_queue[due - 1]
+				dropped = due - 1
+				for i in range(due):
+					_frame_queue.pop_front()
+	pacing_frames_dropped += dropped
+	_mutex.unlock()
+	return chosen
+
+func find_seq_pba(host: PackedByteArray, sub: PackedByteArray, from: int = 0) -> int:
 	var host_len = host.size()
 	var sub_len = sub.size()
 	
@@ -558,36 +789,49 @@ func find_seq_pba(host: PackedByteArray, sub: PackedByteArray) -> int:
 	var first = sub[0]
 	var limit = host_len - sub_len
 	
-	for i in range(limit + 1):
-		# Quick check first byte
-		if host[i] == first:
-			var is_match = true
-			for j in range(1, sub_len):
-				if host[i + j] != sub[j]:
-					is_match = false
-					break
-			if is_match:
-				return i
+	# Native scan for the first byte, then confirm the rest
+	var i = host.find(first, from)
+	while i != -1 and i <= limit:
+		var is_match = true
+		for j in range(1, sub_len):
+			if host[i + j] != sub[j]:
+				is_match = false
+				break
+		if is_match:
+			return i
+		i = host.find(first, i + 1)
 	return -1
 
+# Header check without slicing the packet out of the receive buffer
+func _has_sync_at(buffer: PackedByteArray, pos: int) -> bool:
+	for j in range(SYNC_SEQ.size()):
+		if buffer[pos + j] != SYNC_SEQ[j]:
+			return false
+	return true
+
 
 var last_mouse_state = [0, 0, 0]
 var synched = false
 
 func _process(delta: float) -> void:
-	# 1. POLL FOR NEW FRAMES (Pull Method)
-	var latest_ready = -1
-	if _mutex:
-		_mutex.lock()
-		latest_ready = _ready_index
-		_mutex.unlock()
+	# 1. POLL FOR NEW FRAMES (Pull Method, paced by _select_frame_to_present)
+	var latest_ready = _select_frame_to_present()
 	
 	var is_new_frame = false
-	if latest_ready != -1 and latest_ready != _read_index:
+	if latest_ready != -1:
 		# We have a new frame ready to show!
 		_read_index = latest_ready
 		stream_texture.update(_buffer_images[_read_index])
 		is_new_frame = true
+		if metrics_visible:
+			_mutex.lock()
+			var seq = _buffer_frame_seq[_read_index]
+			metrics_capture_to_read_ms = _buffer_capture_us[_read_index] / 1000.0
+			metrics_read_to_update_ms = (Time.get_ticks_usec() - _buffer_read_ticks[_read_index]) / 1000.0
+			_mutex.unlock()
+			# Gaps in the shim's present counter: frames coalesced, unchanged or dropped before display
+			metrics_frames_skipped = max(0, seq - metrics_frame_seq - 1) if metrics_frame_seq > 0 else 0
+			metrics_frame_seq = seq
 
 	# 2. UPDATE FPS DEBUG
 	if debug_fps_label:
@@ -740,6 +984,10 @@ func _process(delta: float) -> void:
 		
 	# Flush Input Buffer (Single Mutex Lock per frame)
 	if _main_thread_input_buffer.size() > 0:
+		# Stamp with the time the input left the main thread (shim measures latency from here)
+		var ts = _input_timestamp()
+		for packet in _main_thread_input_buffer:
+			packet.append(ts)
 		if _mutex:
 			_mutex.lock()
 			_input_queue.append_array(_main_thread_input_buffer)
@@ -773,10 +1021,32 @@ func _process(delta: float) -> void:
 		if graph_starvation: graph_starvation.add_value(is_stutter)
 		if graph_fps_diff: graph_fps_diff.add_value(fps_diff)
 		
+		var tel: PackedInt64Array
+		if _mutex:
+			_mutex.lock()
+			tel = shim_telemetry
+			_mutex.unlock()
+		if graph_latency and is_new_frame:
+			graph_latency.add_value(metrics_capture_to_read_ms + metrics_read_to_update_ms)
+		if metrics_stage_label and tel.size() == TELEMETRY_BYTES / 4:
+			# present -> write complete comes from the shim, the pipe transit is what's left of capture -> read
+			var shim_ms = (tel[TEL_QUEUE_US] + tel[TEL_ENCODE_US] + tel[TEL_WRITE_US]) / 1000.0
+			metrics_stage_label.text = "queue %.1f  enc %.1f  write %.1f (max %.1f)  pipe %.1f  read->tex %.1f ms\ndropped %d  coalesced %d  poll %d/s  skipped %d" % [
+				tel[TEL_QUEUE_US] / 1000.0, tel[TEL_ENCODE_US] / 1000.0, tel[TEL_WRITE_US] / 1000.0,
+				tel[TEL_WRITE_MAX_US] / 1000.0, max(0.0, metrics_capture_to_read_ms - shim_ms),
+				metrics_read_to_update_ms, tel[TEL_DROPPED], tel[TEL_COALESCED], tel[TEL_POLL_RATE],
+				metrics_frames_skipped]
+		
 		# Data Logging
 		if metrics_logging_enabled and metrics_file:
-			# Format: Timestamp, DisplayFPS, NetJitter, IsStutter, FPSDiff
+			# Format: Timestamp, DisplayFPS, NetJitter, IsStutter, FPSDiff, then per-frame stages and the last shim window
 			var line = "%d,%.2f,%.2f,%d,%.2f" % [now, disp_fps, jitter_val, int(is_stutter), fps_diff]
+			line += ",%d,%.2f,%.2f,%d" % [metrics_frame_seq, metrics_capture_to_read_ms, metrics_read_to_update_ms, metrics_frames_skipped]
+			if tel.size() == TELEMETRY_BYTES / 4:
+				line += ",%d,%d,%d,%d,%d,%d,%d" % [tel[TEL_QUEUE_US], tel[TEL_ENCODE_US], tel[TEL_WRITE_US],
+					tel[TEL_WRITE_MAX_US], tel[TEL_DROPPED], tel[TEL_COALESCED], tel[TEL_POLL_RATE]]
+			else:
+				line += ",,,,,,,"
 			
 			metrics_buffer.append(line)
 			if metrics_buffer.size() >= METRICS_BUFFER_SIZE:
@@ -790,22 +1060,226 @@ var raw_cart_loaded: int = 0
 var raw_master_state: int = 0
 var raw_volume: int = 256
 
-func _process_packet_thread(data: PackedByteArray):
+# Total size of the packet at pos. -1 if the type is unknown, -2 if more bytes are needed to tell
+func _packet_size(buffer: PackedByteArray, pos: int) -> int:
+	match buffer[pos + PACKET_TYPE_INDEX]:
+		PKT_RGBA:
+			return TOTAL_PACKET_SIZE
+		PKT_INDEXED:
+			return INDEXED_PACKET_SIZE
+		PKT_KEEPALIVE:
+			return PACKET_HEADER_BYTES
+		PKT_SHM_FRAME:
+			return PACKET_HEADER_BYTES + SHM_DOORBELL_BYTES
+		PKT_TELEMETRY:
+			return PACKET_HEADER_BYTES + TELEMETRY_BYTES
+		PKT_READY:
+			return PACKET_HEADER_BYTES + READY_BYTES
+		PKT_CONTROL:
+			return PACKET_HEADER_BYTES + CONTROL_BYTES
+		PKT_RGBA_DELTA:
+			var mask_at = pos + PACKET_HEADER_BYTES
+			if buffer.size() < mask_at + ROW_MASK_BYTES:
+				return -2
+			return PACKET_HEADER_BYTES + ROW_MASK_BYTES + _count_rows(buffer, mask_at) * RGBA_ROW_BYTES
+		PKT_INDEXED_DELTA:
+			var mask_at = pos + PACKET_HEADER_BYTES + PALETTE_BYTES
+			if buffer.size() < mask_at + ROW_MASK_BYTES:
+				return -2
+			return PACKET_HEADER_BYTES + PALETTE_BYTES + ROW_MASK_BYTES + _count_rows(buffer, mask_at) * INDEXED_ROW_BYTES
+	return -1
+
+func _count_rows(buffer: PackedByteArray, mask_at: int) -> int:
+	if _popcount.is_empty():
+		_popcount.resize(256)
+		for i in range(256):
+			_popcount[i] = (i & 1) + _popcount[i >> 1]
+	var rows = 0
+	for i in range(ROW_MASK_BYTES):
+		rows += _popcount[buffer[mask_at + i]]
+	return rows
+
+# The packet is parsed where it sits in the receive buffer, starting at pos
+func _process_packet_thread(data: PackedByteArray, pos: int):
 	# Data Structure for debug:
-	# 0-10: "PICO8SYNC__" (11 bytes)
+	# 0-8: "PICO8SYNC" (9 bytes)
+	# 9: Packet Type ('_' = RGBA, 'I' = Indexed, 'K' = Keepalive, 'd'/'i' = RGBA/Indexed row delta, 'S' = Shared ring doorbell, 'C' = Control ack)
+	# 10: Reserved ('_')
 	# 11: NavState (Classic Flags)
 	# 12: MasterState (Editor View / Run State)
 	# 13: Volume (0-144, multiplied by 2 for real value)
-	# 14+: Video Data (8192 bytes)
-	if data.size() >= 14:
-		current_navstate = data[11]
-		raw_master_state = data[12]
-		raw_volume = data[13] * 2
+	# 14-17: Frame sequence number (shim present counter)
+	# 18-21: Capture timestamp (wall clock usec mod 2^32)
+	# 22+: Video Data (RGBA: 65536 bytes | Indexed: 48 byte palette + 8192 bytes | Delta: see PKT_*_DELTA)
+	current_navstate = data[pos + 11]
+	raw_master_state = data[pos + 12]
+	raw_volume = data[pos + 13] * 2
+	var frame_seq = data.decode_u32(pos + FRAME_SEQ_INDEX)
+	var capture_to_read_us = (_input_timestamp() - data.decode_u32(pos + CAPTURE_TS_INDEX)) & 0xFFFFFFFF
+	if capture_to_read_us > 0x7FFFFFFF:
+		capture_to_read_us = 0 # Wall clock stepped backwards
+
+	# Image starts after SYNC + CUSTOM + FRAME INFO
+	var im_start = pos + PACKET_HEADER_BYTES
+	match data[pos + PACKET_TYPE_INDEX]:
+		PKT_KEEPALIVE:
+			# Frame unchanged: keep the current texture, no upload
+			return
+		PKT_TELEMETRY:
+			var tel := PackedInt64Array()
+			tel.resize(TELEMETRY_BYTES / 4)
+			for i in range(tel.size()):
+				tel[i] = data.decode_u32(im_start + i * 4)
+			_mutex.lock()
+			shim_telemetry = tel
+			_mutex.unlock()
+			return
+		PKT_READY:
+			var phases := PackedInt64Array()
+			phases.resize(READY_PHASES.size())
+			for i in range(phases.size()):
+				phases[i] = data.decode_u32(im_start + i * 4)
+			loading.call_deferred("set_visible", false)
+			call_deferred("_report_boot_phases", phases)
+			return
+		PKT_CONTROL:
+			_mutex.lock()
+			control_acked_token = data[im_start]
+			shim_control_flags = data[im_start + 1]
+			shim_fps_cap = data[im_start + 2]
+			is_pico_suspended = (shim_control_flags & CTL_FLAG_PAUSED) != 0
+			_mutex.unlock()
+			return
+		PKT_SHM_FRAME:
+			if not _read_shm_frame(data[im_start], data.decode_u32(im_start + 4)):
+				return
+		PKT_INDEXED:
+			_load_palette(data, im_start)
+			_decode_indexed_rows(data, im_start + PALETTE_BYTES, -1)
+		PKT_INDEXED_DELTA:
+			_load_palette(data, im_start)
+			_decode_indexed_rows(data, im_start + PALETTE_BYTES + ROW_MASK_BYTES, im_start + PALETTE_BYTES)
+		PKT_RGBA_DELTA:
+			_patch_rgba_rows(data, im_start)
+		_:
+			_ensure_frame_rgba()
+			_copy_into_frame(data, im_start, 0, DISPLAY_BYTES)
+	set_im_from_data_threaded(_frame_rgba, frame_seq, capture_to_read_us, data.decode_u32(pos + CAPTURE_TS_INDEX))
+
+# Log time-to-first-frame once per launch: frontend marks (PicoBootManager.mark_boot_phase) and the
+# shim's phases share the wall clock, so they are put on one timeline starting at the earliest mark
+func _report_boot_phases(phases: PackedInt64Array):
+	if PicoBootManager.boot_marks.is_empty():
+		return # Reconnect to an already running PICO-8
+	PicoBootManager.mark_boot_phase("frame shown")
+	var events = PicoBootManager.boot_marks.duplicate()
+	for i in range(phases.size()):
+		if phases[i] != 0:
+			events[READY_PHASES[i]] = phases[i]
+	PicoBootManager.boot_marks.clear()
+
+	var start = events.values()[0]
+	for ts in events.values():
+		if (start - ts) & 0xFFFFFFFF < 0x80000000:
+			start = ts
+	var names = events.keys()
+	names.sort_custom(func(a, b): return (events[a] - start) & 0xFFFFFFFF < (events[b] - start) & 0xFFFFFFFF)
+	var parts = PackedStringArray()
+	for name in names:
+		parts.append("%s +%.1f" % [name, ((events[name] - start) & 0xFFFFFFFF) / 1000.0])
+	print("Boot timeline (ms): ", ", ".join(parts))
+
+# Read the slot announced by a doorbell. False if it was already overwritten or torn.
+func _read_shm_frame(slot: int, seq: int) -> bool:
+	if _shm_file == null and not _open_shm():
+		return false
+	if slot >= _shm_slot_count:
+		return false
+	
+	var slot_at = SHM_HEADER_BYTES + slot * _shm_slot_size
+	_shm_file.seek(slot_at)
+	var seq_before = _shm_file.get_32()
+	var packet_type = _shm_file.get_32()
+	var length = _shm_file.get_32()
+	if seq_before != seq or length > DISPLAY_BYTES:
+		return false
+	
+	_shm_file.seek(slot_at + SHM_SLOT_HEADER_BYTES)
+	var payload = _shm_file.get_buffer(length)
+	
+	# Seqlock check: the shim must not have started rewriting the slot meanwhile
+	_shm_file.seek(slot_at)
+	if _shm_file.get_32() != seq_before or payload.size() != length:
+		return false
+	
+	if packet_type == PKT_INDEXED:
+		_load_palette(payload, 0)
+		_decode_indexed_rows(payload, PALETTE_BYTES, -1)
+	else:
+		_frame_rgba = payload
+	return true
+
+func _open_shm() -> bool:
+	_shm_file = FileAccess.open(PIPE_FB, FileAccess.READ)
+	if _shm_file and _shm_file.get_buffer(SHM_MAGIC.length()).get_string_from_ascii() == SHM_MAGIC:
+		_shm_slot_count = _shm_file.get_32()
+		_shm_slot_size = _shm_file.get_32()
+		print("Pipe: Shared frame ring opened (", _shm_slot_count, " slots)")
+		return true
+	
+	# Fall back to full frames over the FIFO
+	print("Pipe: Shared frame ring unavailable, renegotiating FIFO frames")
+	_shm_file = null
+	video_flags &= ~VID_FLAG_SHM
+	_mutex.lock()
+	_input_queue.push_front([PIDOT_EVENT_VIDMODE, video_encoding, video_flags, 0, 0, 0, 0, 0])
+	_mutex.unlock()
+	return false
 
-	# Image starts after SYNC + CUSTOM
-	var im_start = len(SYNC_SEQ) + CUSTOM_BYTE_COUNT
-	var im = data.slice(im_start, im_start + DISPLAY_BYTES)
-	set_im_from_data_threaded(im)
+func _ensure_frame_rgba():
+	if _frame_rgba.size() != DISPLAY_BYTES:
+		_frame_rgba.resize(DISPLAY_BYTES)
+		_frame_rgba.fill(0)
+
+# Row mask read in place at mask_at. mask_at < 0 = every row present (full frame).
+func _row_in_mask(data: PackedByteArray, mask_at: int, y: int) -> bool:
+	return mask_at < 0 or (data[mask_at + (y >> 3)] & (1 << (y & 7))) != 0
+
+func _load_palette(data: PackedByteArray, offset: int):
+	if _palette_lut.size() != 16:
+		_palette_lut.resize(16)
+	# RGBA8 little-endian word: R | G << 8 | B << 16 | A << 24
+	for c in range(16):
+		var p = offset + c * 3
+		_palette_lut[c] = data[p] | (data[p + 1] << 8) | (data[p + 2] << 16) | 0xFF000000
+
+# Expand 4bpp rows into _frame_rgba. mask_at < 0 = every row present (full frame).
+func _decode_indexed_rows(data: PackedByteArray, offset: int, mask_at: int):
+	_ensure_frame_rgba()
+	var src = offset
+	for y in range(128):
+		if not _row_in_mask(data, mask_at, y):
+			continue
+		var dst = y * RGBA_ROW_BYTES
+		for i in range(INDEXED_ROW_BYTES):
+			var b = data[src + i]
+			_frame_rgba.encode_u32(dst + i * 8, _palette_lut[b & 0x0F])
+			_frame_rgba.encode_u32(dst + i * 8 + 4, _palette_lut[b >> 4])
+		src += INDEXED_ROW_BYTES
+
+# Overwrite the received rows of _frame_rgba in place, kept rows are not touched
+func _patch_rgba_rows(data: PackedByteArray, offset: int):
+	_ensure_frame_rgba()
+	var src = offset + ROW_MASK_BYTES
+	for y in range(128):
+		if _row_in_mask(data, offset, y):
+			_copy_into_frame(data, src, y * RGBA_ROW_BYTES, RGBA_ROW_BYTES)
+			src += RGBA_ROW_BYTES
+
+# byte_count bytes (a multiple of 8) from data at src into _frame_rgba at dst, without a temporary array
+func _copy_into_frame(data: PackedByteArray, src: int, dst: int, byte_count: int):
+	for i in range(0, byte_count, 8):
+		_frame_rgba.encode_s64(dst + i, data.decode_s64(src + i))
 
 
 # --- METRICS SYSTEM ---
@@ -822,11 +1296,19 @@ var graph_fps_diff: DebugGraph
 var metrics_last_frame_time: int = 0
 var metrics_last_packet_time: int = 0
 var metrics_pipe_interval: float = 0.0
+# Per-stage latency of the last displayed frame (main thread) and the last shim telemetry window (under _mutex)
+var graph_latency: DebugGraph
+var metrics_stage_label: Label
+var metrics_frame_seq: int = 0
+var metrics_frames_skipped: int = 0
+var metrics_capture_to_read_ms: float = 0.0
+var metrics_read_to_update_ms: float = 0.0
+var shim_telemetry: PackedInt64Array
 
 func _setup_metrics_display():
 	var container = VBoxContainer.new()
 	container.position = Vector2(50, 150)
-	container.size = Vector2(400, 550) # Increased height
+	container.size = Vector2(400, 700) # Increased height
 	
 	# FPS Graph
 	graph_fps = DebugGraph.new()
@@ -864,6 +1346,20 @@ func _setup_metrics_display():
 	graph_fps_diff.graph_color = Color.ORANGE
 	container.add_child(graph_fps_diff)
 	
+	# End-to-end latency (Present -> Texture Update)
+	graph_latency = DebugGraph.new()
+	graph_latency.label_text = "Present->Display (ms)"
+	graph_latency.min_value = 0
+	graph_latency.max_value = 66
+	graph_latency.custom_minimum_size = Vector2(400, 100)
+	graph_latency.graph_color = Color.MAGENTA
+	container.add_child(graph_latency)
+	
+	# Per-stage breakdown
+	metrics_stage_label = Label.new()
+	metrics_stage_label.add_theme_font_size_override("font_size", 14)
+	container.add_child(metrics_stage_label)
+	
 	var cl = CanvasLayer.new()
 	cl.layer = 129
 	cl.add_child(container)
@@ -884,7 +1380,9 @@ func _start_logging():
 	var path = logs_dir + "/metrics_log_%d.csv" % Time.get_unix_time_from_system()
 	metrics_file = FileAccess.open(path, FileAccess.WRITE)
 	if metrics_file:
-		metrics_file.store_line("Timestamp,DisplayFPS,PipeInterval,IsStutter,FPSDiff")
+		metrics_file.store_line("Timestamp,DisplayFPS,PipeInterval,IsStutter,FPSDiff," +
+			"FrameSeq,CaptureToReadMs,ReadToUpdateMs,SkippedFrames," +
+			"ShimQueueUs,ShimEncodeUs,ShimWriteUs,ShimWriteMaxUs,ShimDropped,ShimCoalesced,PollEventsPerSec")
 		metrics_logging_enabled = true
 		metrics_buffer.clear()
 		print("Metrics logging started: ", path)
@@ -925,6 +1423,8 @@ func toggle_metrics():
 		graph_jitter = null
 		graph_starvation = null
 		graph_fps_diff = null
+		graph_latency = null
+		metrics_stage_label = null
 
 const SDL_KEYMAP: Dictionary = preload("res://sdl_keymap.json").data
 
@@ -936,6 +1436,24 @@ func send_key(id: int, down: bool, repeat: bool, mod: int):
 		mod & 0xff, (mod >> 8) & 0xff, 0, 0
 	])
 			
+func send_snapshot(op: int, slot: int = QUICK_SNAPSHOT_SLOT):
+	_main_thread_input_buffer.append([
+		PIDOT_EVENT_SNAPSHOT, op, slot,
+		0, 0, 0, 0, 0
+	])
+
+# Goes straight to the pipe thread's queue, not through the main thread batch: the main loop may not run
+# again until the app is back in the foreground. Returns the token the shim's ack will carry.
+func send_control(op: int, arg: int = 0) -> int:
+	_control_token = _control_token % 255 + 1 # 0 = nothing acked yet
+	if op == CTL_OP_PAUSE or op == CTL_OP_RESUME:
+		pause_requested = op == CTL_OP_PAUSE
+	if _mutex:
+		_mutex.lock()
+		_input_queue.append([PIDOT_EVENT_CONTROL, op, arg, _control_token, 0, 0, 0, 0, _input_timestamp()])
+		_mutex.unlock()
+	return _control_token
+
 func send_input(char: int):
 	# Add to local buffer (Batching)
 	_main_thread_input_buffer.append([
@@ -976,6 +1494,14 @@ static func set_haptic_enabled(enabled: bool):
 static func get_haptic_enabled() -> bool:
 	return haptic_enabled
 
+enum FramePacing { LOWEST_LATENCY, SMOOTH }
+static var frame_pacing_mode: FramePacing = FramePacing.LOWEST_LATENCY
+static func set_frame_pacing_mode(mode: int):
+	frame_pacing_mode = mode as FramePacing
+
+static func get_frame_pacing_mode() -> int:
+	return frame_pacing_mode
+
 static var swap_zx_enabled: bool = false
 static func set_swap_zx_enabled(enabled: bool):
 	swap_zx_enabled = enabled
@@ -1505,6 +2031,11 @@ func _unhandled_input(event: InputEvent) -> void:
 		# because i keep doing this lolol
 		if event.keycode == KEY_ALT:
 			return
+		# Snapshots fork PICO-8, which only keeps its audio with the shim's direct channel ("stream")
+		if event.keycode == QUICK_SNAPSHOT_KEY and PicoBootManager.get_audio_backend() == "stream":
+			if event.pressed and not event.echo:
+				send_snapshot(SNAP_OP_LOAD if event.shift_pressed else SNAP_OP_SAVE)
+			return
 		var id = OS.get_keycode_string(event.keycode)
 		if id in SDL_KEYMAP:
 			send_key(SDL_KEYMAP[id], event.pressed, event.echo, keymod2sdl(event.get_modifiers_mask(), event.keycode if event.pressed else 0) | keys2sdlmod(held_keys))
@@ -1 +1 @@
-gcc -g -shared -fPIC -ldl -O3 -o picoshim.so shim.c && chmod +x package/rootfs/home/pico/wget && echo BUILT!
+gcc -g -shared -fPIC -pthread -ldl -O3 -o picoshim.so shim.c && gcc -O3 -o pixconv_bench pixconv_bench.c && gcc -O3 -pthread -o cartdec cartdec_cli.c cartdec.c -lz && gcc -O3 -pthread -o picofarm picofarm.c && gcc -O3 -pthread -o capexport capexport.c -lz && gcc -O2 -shared -fPIC -o libmocksdl.so mock_sdl.c && gcc -O3 -pthread -o shim_bench shim_bench.c -L. -l:picoshim.so -l:libmocksdl.so -ldl -Wl,-rpath,'$ORIGIN' && chmod +x package/rootfs/home/pico/wget && echo BUILT!
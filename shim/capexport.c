@@ -0,0 +1,558 @@
+// capexport: turn a PICO_CAPTURE file (see capture.h) into an animated GIF or a PNG sequence.
+// Build: gcc -O3 -pthread -o capexport capexport.c -lz
+// Usage: ./capexport [-s scale] [-f first] [-n count] -o out.gif <capture>
+//        ./capexport [-j jobs] [-s scale] [-f first] [-n count] -o outdir <capture>
+//        ./capexport -i <capture>
+// GIF frames are cropped to what changed and delays follow the recorded timestamps (GIF counts in 1/100 s,
+// so presents closer than 2 cs apart are merged). A PNG sequence keeps every frame and gets a
+// frames.ffconcat next to it with the real durations, for ffmpeg -f concat.
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "capture.h"
+
+#define PIXELS (CAP_WIDTH * CAP_HEIGHT)
+#define GIF_MIN_DELAY_CS 2
+#define PNG_BATCH_PER_JOB 16
+
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    size_t pos;
+    uint8_t flags;
+    uint8_t indices[PIXELS];
+    uint8_t palette[CAP_PALETTE_SIZE];
+    uint8_t meta[CAP_META_SIZE];
+    uint64_t time_us; // Since the first record
+    uint64_t seq;     // Presents since the first record
+    unsigned long record;
+    bool has_key;
+} CapReader;
+
+static int scale = 1;
+static unsigned long first_frame = 0;
+static unsigned long frame_count = (unsigned long)-1;
+
+static uint8_t* read_file(const char* path, size_t* size) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    uint8_t* data = NULL;
+    size_t len = 0, cap = 0, n;
+    do {
+        if (len == cap) {
+            cap = cap ? cap * 2 : 1 << 20;
+            uint8_t* grown = realloc(data, cap);
+            if (!grown) {
+                free(data);
+                fclose(f);
+                return NULL;
+            }
+            data = grown;
+        }
+        n = fread(data + len, 1, cap - len, f);
+        len += n;
+    } while (n > 0);
+    fclose(f);
+    *size = len;
+    return data;
+}
+
+static bool reader_open(CapReader* r, const uint8_t* data, size_t size) {
+    memset(r, 0, sizeof(*r));
+    if (size < CAP_HEADER_SIZE || memcmp(data, CAP_MAGIC, 8) != 0) return false;
+    uint32_t version;
+    uint16_t dims[2];
+    memcpy(&version, data + 8, 4);
+    memcpy(dims, data + 12, 4);
+    if (version != CAP_VERSION || dims[0] != CAP_WIDTH || dims[1] != CAP_HEIGHT) return false;
+    r->data = data;
+    r->size = size;
+    r->pos = CAP_HEADER_SIZE;
+    return true;
+}
+
+// Next record. 1: decoded, 0: end of file (a truncated last record counts as the end), -1: malformed.
+static int reader_next(CapReader* r) {
+    const uint8_t* p = r->data + r->pos;
+    size_t left = r->size - r->pos;
+    if (left < CAP_RECORD_HEADER_SIZE) return 0;
+    uint8_t flags = p[0];
+    uint32_t delta_us;
+    memcpy(&delta_us, p + 2, 4);
+    size_t pos = CAP_RECORD_HEADER_SIZE;
+    if (flags & CAP_FLAG_META) {
+        if (left < pos + CAP_META_SIZE) return 0;
+        memcpy(r->meta, p + pos, CAP_META_SIZE);
+        pos += CAP_META_SIZE;
+    }
+    if (flags & CAP_FLAG_PALETTE) {
+        if (left < pos + CAP_PALETTE_SIZE) return 0;
+        memcpy(r->palette, p + pos, CAP_PALETTE_SIZE);
+        pos += CAP_PALETTE_SIZE;
+    }
+    if (flags & CAP_FLAG_KEY) r->has_key = true;
+    if (flags & CAP_FLAG_ROWS) {
+        if (left < pos + CAP_ROW_MASK_SIZE) return 0;
+        const uint8_t* mask = p + pos;
+        pos += CAP_ROW_MASK_SIZE;
+        for (int y = 0; y < CAP_HEIGHT; y++) {
+            if (!(mask[y >> 3] & (1 << (y & 7)))) continue;
+            size_t n = cap_decode_row(p + pos, left - pos, r->indices + y * CAP_WIDTH);
+            if (!n) return pos >= left ? 0 : -1;
+            pos += n;
+        }
+    }
+    if (r->record) {
+        r->time_us += delta_us;
+        r->seq += p[1];
+    }
+    r->flags = flags;
+    r->pos += pos;
+    r->record++;
+    return 1;
+}
+
+static void to_rgb(const CapReader* r, uint32_t* rgb) {
+    uint32_t colors[CAP_COLORS];
+    for (int c = 0; c < CAP_COLORS; c++) {
+        colors[c] = (uint32_t)r->palette[c * 3] << 16 | r->palette[c * 3 + 1] << 8 | r->palette[c * 3 + 2];
+    }
+    for (int i = 0; i < PIXELS; i++) rgb[i] = colors[r->indices[i]];
+}
+
+// Frames before a key record can't be shown (a capture always starts with one, this is for damaged files)
+static bool in_range(const CapReader* r) {
+    unsigned long frame = r->record - 1;
+    return r->has_key && frame >= first_frame && frame - first_frame < frame_count;
+}
+
+// ---- Info
+
+static int print_info(CapReader* r) {
+    unsigned long keys = 0, repeats = 0, gaps = 0, missed = 0, palettes = 0;
+    uint32_t max_delta = 0;
+    uint64_t last_us = 0;
+    size_t max_record = 0, last_pos = r->pos;
+    int status;
+    while ((status = reader_next(r)) == 1) {
+        size_t record_size = r->pos - last_pos;
+        uint32_t delta = (uint32_t)(r->time_us - last_us);
+        uint8_t gap = r->data[last_pos + 1];
+        last_pos = r->pos;
+        last_us = r->time_us;
+        if (record_size > max_record) max_record = record_size;
+        if (r->record > 1 && delta > max_delta) max_delta = delta;
+        if (r->flags & CAP_FLAG_KEY) keys++;
+        if (r->flags & CAP_FLAG_PALETTE) palettes++;
+        if (r->flags & CAP_FLAG_NO_PIXELS) repeats++;
+        if (r->record > 1 && gap != 1) {
+            gaps++;
+            missed += gap ? gap - 1 : 0;
+        }
+    }
+    double seconds = r->time_us / 1e6;
+    printf("frames:    %lu (%lu key, %lu palette changes, %lu without pixels)\n", r->record, keys, palettes, repeats);
+    printf("duration:  %.2f s (%.2f fps, longest gap %.1f ms)\n", seconds,
+           seconds > 0 ? (r->record - 1) / seconds : 0.0, max_delta / 1000.0);
+    printf("size:      %zu bytes (%.1f per frame, largest %zu, %.1f KB/min)\n", r->pos,
+           r->record ? (double)(r->pos - CAP_HEADER_SIZE) / r->record : 0.0, max_record,
+           seconds > 0 ? r->pos / 1024.0 / (seconds / 60) : 0.0);
+    printf("dropped:   %lu frames in %lu gaps\n", missed, gaps);
+    if (status < 0) {
+        fprintf(stderr, "capexport: malformed record %lu at offset %zu\n", r->record, r->pos);
+        return 1;
+    }
+    if (r->pos != r->size) printf("truncated: %zu trailing bytes ignored\n", r->size - r->pos);
+    return 0;
+}
+
+// ---- GIF
+
+typedef struct {
+    FILE* f;
+    uint8_t block[255];
+    int block_len;
+    uint32_t bits;
+    int bit_count;
+} GifBits;
+
+static void gif_put_byte(GifBits* g, uint8_t b) {
+    g->block[g->block_len++] = b;
+    if (g->block_len == 255) {
+        fputc(255, g->f);
+        fwrite(g->block, 1, 255, g->f);
+        g->block_len = 0;
+    }
+}
+
+static void gif_put_code(GifBits* g, int code, int size) {
+    g->bits |= (uint32_t)code << g->bit_count;
+    g->bit_count += size;
+    while (g->bit_count >= 8) {
+        gif_put_byte(g, g->bits & 0xFF);
+        g->bits >>= 8;
+        g->bit_count -= 8;
+    }
+}
+
+// LZW over 4-bit indices. With a 16 symbol alphabet the dictionary is a plain [code][symbol] table.
+static void gif_lzw(FILE* f, const uint8_t* pixels, int count) {
+    enum { MIN_CODE_SIZE = 4, CLEAR = 1 << MIN_CODE_SIZE, EOI = CLEAR + 1, MAX_CODES = 4096 };
+    static uint16_t next[MAX_CODES][CAP_COLORS];
+    GifBits g = {.f = f};
+    fputc(MIN_CODE_SIZE, f);
+    memset(next, 0, sizeof(next));
+    int code_size = MIN_CODE_SIZE + 1;
+    int next_code = EOI + 1;
+    gif_put_code(&g, CLEAR, code_size);
+    int prefix = pixels[0];
+    for (int i = 1; i < count; i++) {
+        uint8_t c = pixels[i];
+        if (next[prefix][c]) {
+            prefix = next[prefix][c];
+            continue;
+        }
+        gif_put_code(&g, prefix, code_size);
+        if (next_code < MAX_CODES) {
+            next[prefix][c] = (uint16_t)next_code;
+            if (next_code++ == 1 << code_size && code_size < 12) code_size++;
+        } else {
+            gif_put_code(&g, CLEAR, code_size);
+            memset(next, 0, sizeof(next));
+            code_size = MIN_CODE_SIZE + 1;
+            next_code = EOI + 1;
+        }
+        prefix = c;
+    }
+    gif_put_code(&g, prefix, code_size);
+    // The decoder adds an entry after this code too, so it may already read the next one wider
+    if (next_code < MAX_CODES && next_code == 1 << code_size && code_size < 12) code_size++;
+    gif_put_code(&g, EOI, code_size);
+    if (g.bit_count) gif_put_byte(&g, g.bits & 0xFF);
+    if (g.block_len) {
+        fputc(g.block_len, f);
+        fwrite(g.block, 1, g.block_len, f);
+    }
+    fputc(0, f);
+}
+
+static void put_u16(FILE* f, int v) {
+    fputc(v & 0xFF, f);
+    fputc((v >> 8) & 0xFF, f);
+}
+
+typedef struct {
+    FILE* f;
+    uint8_t global_palette[CAP_PALETTE_SIZE];
+    uint32_t canvas[PIXELS]; // What a viewer shows after the last written frame
+    bool started;
+    unsigned long written;
+} Gif;
+
+static void gif_start(Gif* gif, const uint8_t* palette) {
+    int w = CAP_WIDTH * scale, h = CAP_HEIGHT * scale;
+    fwrite("GIF89a", 1, 6, gif->f);
+    put_u16(gif->f, w);
+    put_u16(gif->f, h);
+    fputc(0xF3, gif->f); // Global color table of 16 entries
+    fputc(0, gif->f);
+    fputc(0, gif->f);
+    fwrite(palette, 1, CAP_PALETTE_SIZE, gif->f);
+    memcpy(gif->global_palette, palette, CAP_PALETTE_SIZE);
+    static const uint8_t loop[] = {0x21, 0xFF, 0x0B, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E', '2', '.', '0', 3, 1, 0, 0, 0};
+    fwrite(loop, 1, sizeof(loop), gif->f);
+    gif->started = true;
+}
+
+// Writes the part of the frame that differs from the canvas, shown for delay_cs
+static void gif_frame(Gif* gif, const uint8_t* indices, const uint8_t* palette, const uint32_t* rgb, int delay_cs) {
+    int x0 = CAP_WIDTH, y0 = CAP_HEIGHT, x1 = -1, y1 = -1;
+    if (!gif->written) {
+        x0 = y0 = 0;
+        x1 = CAP_WIDTH - 1;
+        y1 = CAP_HEIGHT - 1;
+    } else {
+        for (int y = 0; y < CAP_HEIGHT; y++) {
+            const uint32_t* row = rgb + y * CAP_WIDTH;
+            const uint32_t* old = gif->canvas + y * CAP_WIDTH;
+            int first = 0, last = CAP_WIDTH - 1;
+            while (first < CAP_WIDTH && row[first] == old[first]) first++;
+            if (first == CAP_WIDTH) continue;
+            while (row[last] == old[last]) last--;
+            if (first < x0) x0 = first;
+            if (last > x1) x1 = last;
+            if (y < y0) y0 = y;
+            y1 = y;
+        }
+        if (x1 < 0) x0 = y0 = x1 = y1 = 0; // Nothing changed but the delay still has to be written
+    }
+    memcpy(gif->canvas, rgb, sizeof(gif->canvas));
+
+    int w = (x1 - x0 + 1) * scale, h = (y1 - y0 + 1) * scale;
+    if (delay_cs > 0xFFFF) delay_cs = 0xFFFF;
+    const uint8_t control[] = {0x21, 0xF9, 4, 1 << 2, delay_cs & 0xFF, delay_cs >> 8, 0, 0}; // Disposal 1: keep
+    fwrite(control, 1, sizeof(control), gif->f);
+    bool local = memcmp(palette, gif->global_palette, CAP_PALETTE_SIZE) != 0;
+    fputc(0x2C, gif->f);
+    put_u16(gif->f, x0 * scale);
+    put_u16(gif->f, y0 * scale);
+    put_u16(gif->f, w);
+    put_u16(gif->f, h);
+    fputc(local ? 0x83 : 0, gif->f);
+    if (local) fwrite(palette, 1, CAP_PALETTE_SIZE, gif->f);
+
+    static uint8_t sub[PIXELS * 16 * 16];
+    uint8_t* out = sub;
+    for (int y = y0; y <= y1; y++) {
+        uint8_t* line = out;
+        for (int x = x0; x <= x1; x++) {
+            memset(out, indices[y * CAP_WIDTH + x], scale);
+            out += scale;
+        }
+        for (int i = 1; i < scale; i++, out += w) memcpy(out, line, w);
+    }
+    gif_lzw(gif->f, sub, w * h);
+    gif->written++;
+}
+
+static int export_gif(CapReader* r, const char* path) {
+    Gif gif = {0};
+    gif.f = fopen(path, "wb");
+    if (!gif.f) {
+        perror(path);
+        return 1;
+    }
+    setvbuf(gif.f, NULL, _IOFBF, 1 << 18);
+    // The frame waiting for its delay, which is only known once the next different frame arrives
+    static uint8_t pending[PIXELS];
+    static uint32_t pending_rgb[PIXELS], rgb[PIXELS];
+    uint8_t pending_palette[CAP_PALETTE_SIZE];
+    bool has_pending = false;
+    uint64_t pending_cs = 0;
+    unsigned long frames = 0;
+    int status;
+    while ((status = reader_next(r)) == 1) {
+        if (!in_range(r)) {
+            if (r->record - 1 >= first_frame) break;
+            continue;
+        }
+        frames++;
+        uint64_t cs = (r->time_us + 5000) / 10000;
+        if (has_pending) {
+            to_rgb(r, rgb);
+            if (memcmp(rgb, pending_rgb, sizeof(rgb)) == 0) continue;
+            if (cs - pending_cs >= GIF_MIN_DELAY_CS) {
+                if (!gif.started) gif_start(&gif, pending_palette);
+                gif_frame(&gif, pending, pending_palette, pending_rgb, (int)(cs - pending_cs));
+                pending_cs = cs;
+            }
+            memcpy(pending_rgb, rgb, sizeof(rgb));
+        } else {
+            to_rgb(r, pending_rgb);
+            pending_cs = cs;
+            has_pending = true;
+        }
+        memcpy(pending, r->indices, PIXELS);
+        memcpy(pending_palette, r->palette, CAP_PALETTE_SIZE);
+    }
+    if (has_pending) {
+        if (!gif.started) gif_start(&gif, pending_palette);
+        gif_frame(&gif, pending, pending_palette, pending_rgb, 100);
+    }
+    if (gif.started) fputc(0x3B, gif.f);
+    if (fclose(gif.f) != 0 || !gif.started) {
+        fprintf(stderr, "capexport: %s\n", gif.started ? strerror(errno) : "no frames in range");
+        return 1;
+    }
+    printf("%s: %lu frames as %lu GIF frames\n", path, frames, gif.written);
+    if (status < 0) fprintf(stderr, "capexport: malformed record %lu, stopped there\n", r->record);
+    return status < 0;
+}
+
+// ---- PNG sequence
+
+typedef struct {
+    unsigned long frame;
+    uint8_t indices[PIXELS];
+    uint8_t palette[CAP_PALETTE_SIZE];
+} PngJob;
+
+static PngJob* png_jobs;
+static size_t png_job_count;
+static atomic_size_t png_next;
+static atomic_int png_failed;
+static const char* png_dir;
+
+static void png_chunk(FILE* f, const char* type, const uint8_t* data, uint32_t len) {
+    uint8_t be[4] = {len >> 24, len >> 16, len >> 8, len};
+    fwrite(be, 1, 4, f);
+    fwrite(type, 1, 4, f);
+    if (len) fwrite(data, 1, len, f);
+    uLong crc = crc32(0, (const Bytef*)type, 4);
+    if (len) crc = crc32(crc, data, len); // crc32() returns 0 for a NULL buffer
+    uint8_t crc_be[4] = {crc >> 24, crc >> 16, crc >> 8, crc};
+    fwrite(crc_be, 1, 4, f);
+}
+
+// 4-bit indexed PNG, rows unfiltered: the content is flat colors, filtering only costs time
+static bool png_write(const PngJob* job, uint8_t* raw, size_t raw_size, uint8_t* packed, uLong packed_size) {
+    int w = CAP_WIDTH * scale, h = CAP_HEIGHT * scale, stride = 1 + w / 2;
+    for (int y = 0; y < h; y++) {
+        const uint8_t* src = job->indices + (y / scale) * CAP_WIDTH;
+        uint8_t* row = raw + y * stride;
+        row[0] = 0;
+        for (int x = 0; x < w; x += 2) {
+            row[1 + x / 2] = (uint8_t)(src[x / scale] << 4 | src[(x + 1) / scale]);
+        }
+    }
+    if (compress2(packed, &packed_size, raw, raw_size, 6) != Z_OK) return false;
+
+    char* path;
+    if (asprintf(&path, "%s/frame_%06lu.png", png_dir, job->frame) < 0) return false;
+    FILE* f = fopen(path, "wb");
+    free(path);
+    if (!f) return false;
+    static const uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    uint8_t ihdr[13] = {w >> 24, w >> 16, w >> 8, w, h >> 24, h >> 16, h >> 8, h, 4, 3, 0, 0, 0};
+    fwrite(signature, 1, sizeof(signature), f);
+    png_chunk(f, "IHDR", ihdr, sizeof(ihdr));
+    png_chunk(f, "PLTE", job->palette, CAP_PALETTE_SIZE);
+    png_chunk(f, "IDAT", packed, (uint32_t)packed_size);
+    png_chunk(f, "IEND", NULL, 0);
+    return fclose(f) == 0;
+}
+
+static void* png_worker(void* arg) {
+    (void)arg;
+    size_t raw_size = (size_t)CAP_HEIGHT * scale * (1 + CAP_WIDTH * scale / 2);
+    uLong packed_size = compressBound(raw_size);
+    uint8_t* raw = malloc(raw_size);
+    uint8_t* packed = malloc(packed_size);
+    size_t i;
+    while ((i = atomic_fetch_add(&png_next, 1)) < png_job_count) {
+        if (!raw || !packed || !png_write(&png_jobs[i], raw, raw_size, packed, packed_size)) {
+            fprintf(stderr, "capexport: frame %lu: %s\n", png_jobs[i].frame, strerror(errno));
+            atomic_fetch_add(&png_failed, 1);
+        }
+    }
+    free(raw);
+    free(packed);
+    return NULL;
+}
+
+static void png_flush(pthread_t* threads, int jobs) {
+    atomic_store(&png_next, 0);
+    for (int t = 0; t < jobs; t++) pthread_create(&threads[t], NULL, png_worker, NULL);
+    for (int t = 0; t < jobs; t++) pthread_join(threads[t], NULL);
+    png_job_count = 0;
+}
+
+// Decoding is sequential (every record is a delta), so frames are decoded in batches and compressed in parallel
+static int export_png(CapReader* r, const char* dir, int jobs) {
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        perror(dir);
+        return 1;
+    }
+    char* concat_path;
+    if (asprintf(&concat_path, "%s/frames.ffconcat", dir) < 0) return 1;
+    FILE* concat = fopen(concat_path, "w");
+    free(concat_path);
+    if (!concat) {
+        perror(dir);
+        return 1;
+    }
+    fprintf(concat, "ffconcat version 1.0\n");
+
+    png_dir = dir;
+    size_t batch = (size_t)jobs * PNG_BATCH_PER_JOB;
+    png_jobs = malloc(batch * sizeof(PngJob));
+    pthread_t* threads = malloc(jobs * sizeof(pthread_t));
+    if (!png_jobs || !threads) {
+        perror("capexport");
+        return 1;
+    }
+    unsigned long frames = 0, last_frame = 0;
+    uint64_t last_us = 0;
+    int status;
+    while ((status = reader_next(r)) == 1) {
+        if (!in_range(r)) {
+            if (r->record - 1 >= first_frame) break;
+            continue;
+        }
+        unsigned long frame = r->record - 1;
+        if (frames++) fprintf(concat, "file frame_%06lu.png\nduration %.6f\n", last_frame, (r->time_us - last_us) / 1e6);
+        last_frame = frame;
+        last_us = r->time_us;
+        PngJob* job = &png_jobs[png_job_count++];
+        job->frame = frame;
+        memcpy(job->indices, r->indices, PIXELS);
+        memcpy(job->palette, r->palette, CAP_PALETTE_SIZE);
+        if (png_job_count == batch) png_flush(threads, jobs);
+    }
+    if (png_job_count) png_flush(threads, jobs);
+    // ffconcat ignores the duration of the last entry, so it is listed twice
+    if (frames) fprintf(concat, "file frame_%06lu.png\nduration 0.016667\nfile frame_%06lu.png\n", last_frame, last_frame);
+    fclose(concat);
+    free(png_jobs);
+    free(threads);
+    printf("%s: %lu PNG frames, %d failed\n", dir, frames, atomic_load(&png_failed));
+    if (status < 0) fprintf(stderr, "capexport: malformed record %lu, stopped there\n", r->record);
+    return status < 0 || atomic_load(&png_failed) > 0 || frames == 0;
+}
+
+static void usage() {
+    fprintf(stderr, "Usage: capexport [-j jobs] [-s scale] [-f first] [-n count] -o out.gif|outdir <capture>\n"
+                    "       capexport -i <capture>\n");
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    int jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    const char* out = NULL;
+    bool info = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "j:s:f:n:o:i")) != -1) {
+        switch (opt) {
+            case 'j': jobs = atoi(optarg); break;
+            case 's': scale = atoi(optarg); break;
+            case 'f': first_frame = strtoul(optarg, NULL, 10); break;
+            case 'n': frame_count = strtoul(optarg, NULL, 10); break;
+            case 'o': out = optarg; break;
+            case 'i': info = true; break;
+            default: usage();
+        }
+    }
+    if (optind != argc - 1 || (!out && !info) || scale < 1 || scale > 16) usage();
+    if (jobs < 1) jobs = 1;
+
+    size_t size;
+    uint8_t* data = read_file(argv[optind], &size);
+    if (!data) {
+        perror(argv[optind]);
+        return 1;
+    }
+    static CapReader reader;
+    if (!reader_open(&reader, data, size)) {
+        fprintf(stderr, "capexport: %s is not a version %d capture\n", argv[optind], CAP_VERSION);
+        return 1;
+    }
+    size_t len = out ? strlen(out) : 0;
+    int status;
+    if (info) {
+        status = print_info(&reader);
+    } else if (len > 4 && strcasecmp(out + len - 4, ".gif") == 0) {
+        status = export_gif(&reader, out);
+    } else {
+        status = export_png(&reader, out, jobs);
+    }
+    free(data);
+    return status;
+}
@@ -0,0 +1,141 @@
+// Gameplay capture format, written by shim.c (PICO_CAPTURE) and read by capexport.c.
+// File: "PICO8CAP"(8) + Version(4) + Width(2) + Height(2), then one record per captured present:
+//   Flags(1) + SeqGap(1) + DeltaUs(4) [+ Meta(3)] [+ Palette(48)] [+ RowMask(16) + rows]
+// SeqGap: presents since the previous record (1 = none missed, saturates at 255). DeltaUs: capture time
+// since the previous record. Meta and Palette are only there when they changed. Pixels are indices into
+// the palette, which keeps its order across frames so unchanged pixels keep their index.
+// A row in the mask is stored as X(1) + Count(1) + the span of pixels that changed since the previous
+// record. X bit 7 set: packed 4bpp (low nibble = left pixel), clear: runs, one byte each ((length-1) << 4 | index).
+// Key records carry all rows in full and the palette, a reader can start at any of them.
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define CAP_MAGIC "PICO8CAP"
+#define CAP_VERSION 1
+#define CAP_HEADER_SIZE 16
+#define CAP_WIDTH 128
+#define CAP_HEIGHT 128
+#define CAP_COLORS 16
+#define CAP_PALETTE_SIZE (CAP_COLORS * 3)
+#define CAP_ROW_MASK_SIZE (CAP_HEIGHT / 8)
+#define CAP_META_SIZE 3
+#define CAP_RECORD_HEADER_SIZE 6
+#define CAP_ROW_MAX (2 + CAP_WIDTH) // Runs never exceed one byte per pixel
+#define CAP_RECORD_MAX (CAP_RECORD_HEADER_SIZE + CAP_META_SIZE + CAP_PALETTE_SIZE + CAP_ROW_MASK_SIZE + CAP_HEIGHT * CAP_ROW_MAX)
+
+#define CAP_FLAG_META 0x01
+#define CAP_FLAG_PALETTE 0x02
+#define CAP_FLAG_ROWS 0x04
+#define CAP_FLAG_KEY 0x08
+#define CAP_FLAG_NO_PIXELS 0x10 // Surface had no pixels, the frame is a repeat
+
+#define CAP_SPAN_PACKED 0x80
+
+typedef struct {
+    uint32_t colors[CAP_COLORS]; // XRGB
+    int count;
+} CapPalette;
+
+// XRGB surface -> indices. New colors are appended to the palette; if it overflows, it is rebuilt from
+// this frame alone and *rebuilt is set (every index may have changed), as it is when the palette starts
+// empty (first frame, or after a failed one). False if the frame has > 16 colors.
+static inline bool cap_index_frame(const uint32_t* src, uint8_t* indices, CapPalette* palette, bool* rebuilt) {
+    *rebuilt = palette->count == 0;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        uint32_t last_color = 0xFFFFFFFF;
+        uint8_t last_index = 0;
+        int i = 0;
+        for (; i < CAP_WIDTH * CAP_HEIGHT; i++) {
+            uint32_t color = src[i] & 0x00FFFFFF;
+            if (color != last_color) {
+                int idx = 0;
+                while (idx < palette->count && palette->colors[idx] != color) idx++;
+                if (idx == palette->count) {
+                    if (palette->count == CAP_COLORS) break;
+                    palette->colors[palette->count++] = color;
+                }
+                last_color = color;
+                last_index = (uint8_t)idx;
+            }
+            indices[i] = last_index;
+        }
+        if (i == CAP_WIDTH * CAP_HEIGHT) return true;
+        palette->count = 0;
+        *rebuilt = true;
+    }
+    return false;
+}
+
+static inline void cap_palette_bytes(const CapPalette* palette, uint8_t* out) {
+    for (int c = 0; c < CAP_COLORS; c++) {
+        uint32_t color = c < palette->count ? palette->colors[c] : 0;
+        out[c * 3] = (color >> 16) & 0xFF;
+        out[c * 3 + 1] = (color >> 8) & 0xFF;
+        out[c * 3 + 2] = color & 0xFF;
+    }
+}
+
+// One row, only the span that differs from prev (NULL: the whole row). Returns bytes written, 0 if unchanged.
+static inline size_t cap_encode_row(const uint8_t* row, const uint8_t* prev, uint8_t* out) {
+    int first = 0, last = CAP_WIDTH - 1;
+    if (prev) {
+        while (first < CAP_WIDTH && row[first] == prev[first]) first++;
+        if (first == CAP_WIDTH) return 0;
+        while (row[last] == prev[last]) last--;
+    }
+    int count = last - first + 1;
+    uint8_t* runs = out + 2;
+    size_t run_bytes = 0;
+    for (int x = first; x <= last; ) {
+        int length = 1;
+        while (x + length <= last && length < 16 && row[x + length] == row[x]) length++;
+        runs[run_bytes++] = (uint8_t)(((length - 1) << 4) | row[x]);
+        x += length;
+    }
+    size_t packed_bytes = (size_t)(count + 1) / 2;
+    out[1] = (uint8_t)(count - 1);
+    if (run_bytes <= packed_bytes) {
+        out[0] = (uint8_t)first;
+        return 2 + run_bytes;
+    }
+    out[0] = (uint8_t)first | CAP_SPAN_PACKED;
+    for (int i = 0; i < count; i += 2) {
+        uint8_t hi = i + 1 < count ? row[first + i + 1] : 0;
+        runs[i / 2] = (uint8_t)(row[first + i] | (hi << 4));
+    }
+    return 2 + packed_bytes;
+}
+
+// Applies one encoded row onto row. Returns the bytes consumed, 0 if malformed.
+static inline size_t cap_decode_row(const uint8_t* in, size_t available, uint8_t* row) {
+    if (available < 2) return 0;
+    int first = in[0] & ~CAP_SPAN_PACKED;
+    int count = in[1] + 1;
+    if (first + count > CAP_WIDTH) return 0;
+    if (in[0] & CAP_SPAN_PACKED) {
+        size_t bytes = (size_t)(count + 1) / 2;
+        if (available < 2 + bytes) return 0;
+        for (int i = 0; i < count; i++) {
+            uint8_t b = in[2 + i / 2];
+            row[first + i] = (i & 1) ? b >> 4 : b & 0x0F;
+        }
+        return 2 + bytes;
+    }
+    size_t pos = 2;
+    for (int x = first; x < first + count; ) {
+        if (pos >= available) return 0;
+        int length = (in[pos] >> 4) + 1;
+        if (x + length > first + count) return 0;
+        memset(row + x, in[pos] & 0x0F, length);
+        x += length;
+        pos++;
+    }
+    return pos;
+}
+
+#endif
@@ -0,0 +1,695 @@
+// PICO-8 .p8.png decoder, see cartdec.h.
+// Everything works on memory buffers so the CLI can decode carts on as many threads as it likes.
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include "cartdec.h"
+
+#define STEGO_HASH_ADDR 0x8006 // SHA1 of the first 0x8000 bytes, all zero on old carts
+#define STEGO_SIZE 0x801A
+#define PNG_MAX_DIM 4096
+
+#define MEM_SPRITES_ADDR 0x0000
+#define MEM_MAP_ADDR 0x2000
+#define MEM_FLAG_ADDR 0x3000
+#define MEM_MUSIC_ADDR 0x3100
+#define MEM_SFX_ADDR 0x3200
+
+// --- PNG -------------------------------------------------------------------
+
+static uint32_t be32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint8_t paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return (uint8_t)a;
+    return (uint8_t)(pb <= pc ? b : c);
+}
+
+// Undo the per-row filters in place. bpp = bytes per pixel, rows are 1 filter byte + stride.
+static int png_unfilter(uint8_t* raw, uint32_t height, size_t stride, int bpp) {
+    const uint8_t* prev = NULL;
+    for (uint32_t y = 0; y < height; y++) {
+        uint8_t filter = raw[y * (stride + 1)];
+        uint8_t* row = raw + y * (stride + 1) + 1;
+        switch (filter) {
+        case 0:
+            break;
+        case 1:
+            for (size_t i = bpp; i < stride; i++) row[i] += row[i - bpp];
+            break;
+        case 2:
+            if (prev) for (size_t i = 0; i < stride; i++) row[i] += prev[i];
+            break;
+        case 3:
+            for (size_t i = 0; i < stride; i++) {
+                int left = i >= (size_t)bpp ? row[i - bpp] : 0;
+                int up = prev ? prev[i] : 0;
+                row[i] += (uint8_t)((left + up) >> 1);
+            }
+            break;
+        case 4:
+            for (size_t i = 0; i < stride; i++) {
+                int left = i >= (size_t)bpp ? row[i - bpp] : 0;
+                int up = prev ? prev[i] : 0;
+                int up_left = (prev && i >= (size_t)bpp) ? prev[i - bpp] : 0;
+                row[i] += paeth(left, up, up_left);
+            }
+            break;
+        default:
+            return CARTDEC_ERR_PNG;
+        }
+        prev = row;
+    }
+    return CARTDEC_OK;
+}
+
+// Decode to RGBA8. Carts are always 8 bit RGBA; RGB and palette images are accepted for re-saved carts.
+static int png_decode_rgba(const uint8_t* png, size_t len, uint8_t** out, uint32_t* out_w, uint32_t* out_h) {
+    static const uint8_t sig[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    if (len < 8 || memcmp(png, sig, 8) != 0) return CARTDEC_ERR_PNG;
+
+    uint32_t w = 0, h = 0;
+    int color_type = -1, channels = 0;
+    uint8_t palette[256][4];
+    memset(palette, 0xFF, sizeof(palette));
+    uint8_t* raw = NULL;
+    size_t stride = 0, raw_size = 0;
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    int inflating = 0, done = 0;
+    int err = CARTDEC_OK;
+
+    size_t pos = 8;
+    while (!done && pos + 12 <= len) {
+        uint32_t chunk_len = be32(png + pos);
+        const uint8_t* type = png + pos + 4;
+        const uint8_t* data = png + pos + 8;
+        if (chunk_len > len - pos - 12) { err = CARTDEC_ERR_PNG; break; }
+
+        if (memcmp(type, "IHDR", 4) == 0) {
+            if (raw || chunk_len < 13) { err = CARTDEC_ERR_PNG; break; }
+            w = be32(data);
+            h = be32(data + 4);
+            color_type = data[9];
+            channels = color_type == 6 ? 4 : color_type == 2 ? 3 : color_type == 3 ? 1 : 0;
+            // data[8] = bit depth, data[12] = interlace
+            if (data[8] != 8 || channels == 0 || data[12] != 0 ||
+                w == 0 || h == 0 || w > PNG_MAX_DIM || h > PNG_MAX_DIM) { err = CARTDEC_ERR_PNG; break; }
+            stride = (size_t)w * channels;
+            raw_size = (stride + 1) * h;
+            raw = malloc(raw_size);
+            if (!raw) { err = CARTDEC_ERR_NOMEM; break; }
+            if (inflateInit(&zs) != Z_OK) { err = CARTDEC_ERR_NOMEM; break; }
+            inflating = 1;
+            zs.next_out = raw;
+            zs.avail_out = (uInt)raw_size;
+        } else if (memcmp(type, "PLTE", 4) == 0) {
+            for (uint32_t i = 0; i < chunk_len / 3 && i < 256; i++) {
+                palette[i][0] = data[i * 3];
+                palette[i][1] = data[i * 3 + 1];
+                palette[i][2] = data[i * 3 + 2];
+            }
+        } else if (memcmp(type, "tRNS", 4) == 0) {
+            if (color_type == 3) {
+                for (uint32_t i = 0; i < chunk_len && i < 256; i++) palette[i][3] = data[i];
+            }
+        } else if (memcmp(type, "IDAT", 4) == 0) {
+            if (!inflating) { err = CARTDEC_ERR_PNG; break; }
+            zs.next_in = (Bytef*)data;
+            zs.avail_in = chunk_len;
+            while (zs.avail_in > 0 && zs.avail_out > 0) {
+                int ret = inflate(&zs, Z_NO_FLUSH);
+                if (ret == Z_STREAM_END) break;
+                if (ret != Z_OK) { err = CARTDEC_ERR_PNG; break; }
+            }
+            if (err) break;
+        } else if (memcmp(type, "IEND", 4) == 0) {
+            done = 1;
+        }
+        pos += 12 + (size_t)chunk_len;
+    }
+
+    if (inflating) {
+        if (!err && zs.total_out != raw_size) err = CARTDEC_ERR_PNG;
+        inflateEnd(&zs);
+    }
+    if (!err && !raw) err = CARTDEC_ERR_PNG;
+    if (!err) err = png_unfilter(raw, h, stride, channels);
+
+    uint8_t* rgba = NULL;
+    if (!err) {
+        rgba = malloc((size_t)w * h * 4);
+        if (!rgba) err = CARTDEC_ERR_NOMEM;
+    }
+    if (!err) {
+        for (uint32_t y = 0; y < h; y++) {
+            const uint8_t* src = raw + y * (stride + 1) + 1;
+            uint8_t* dst = rgba + (size_t)y * w * 4;
+            if (color_type == 6) {
+                memcpy(dst, src, stride);
+            } else if (color_type == 2) {
+                for (uint32_t x = 0; x < w; x++) {
+                    dst[x * 4] = src[x * 3];
+                    dst[x * 4 + 1] = src[x * 3 + 1];
+                    dst[x * 4 + 2] = src[x * 3 + 2];
+                    dst[x * 4 + 3] = 0xFF;
+                }
+            } else {
+                for (uint32_t x = 0; x < w; x++) memcpy(dst + x * 4, palette[src[x]], 4);
+            }
+        }
+        *out = rgba;
+        *out_w = w;
+        *out_h = h;
+    }
+    free(raw);
+    return err;
+}
+
+// --- SHA1 (integrity check only) -------------------------------------------
+
+static uint32_t rol32(uint32_t v, int n) { return (v << n) | (v >> (32 - n)); }
+
+static void sha1_block(uint32_t state[5], const uint8_t* block) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) w[i] = be32(block + i * 4);
+    for (int i = 16; i < 80; i++) w[i] = rol32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) { f = (b & c) | (~b & d); k = 0x5A827999; }
+        else if (i < 40) { f = b ^ c ^ d; k = 0x6ED9EBA1; }
+        else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+        else { f = b ^ c ^ d; k = 0xCA62C1D6; }
+        uint32_t t = rol32(a, 5) + f + e + k + w[i];
+        e = d; d = c; c = rol32(b, 30); b = a; a = t;
+    }
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d; state[4] += e;
+}
+
+static void sha1(const uint8_t* data, size_t len, uint8_t digest[20]) {
+    uint32_t state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    size_t full = len & ~(size_t)63;
+    for (size_t i = 0; i < full; i += 64) sha1_block(state, data + i);
+    uint8_t tail[128] = {0};
+    size_t rest = len - full;
+    memcpy(tail, data + full, rest);
+    tail[rest] = 0x80;
+    size_t tail_len = rest < 56 ? 64 : 128;
+    uint64_t bits = (uint64_t)len * 8;
+    for (int i = 0; i < 8; i++) tail[tail_len - 1 - i] = (uint8_t)(bits >> (i * 8));
+    for (size_t i = 0; i < tail_len; i += 64) sha1_block(state, tail + i);
+    for (int i = 0; i < 5; i++) {
+        digest[i * 4] = (uint8_t)(state[i] >> 24);
+        digest[i * 4 + 1] = (uint8_t)(state[i] >> 16);
+        digest[i * 4 + 2] = (uint8_t)(state[i] >> 8);
+        digest[i * 4 + 3] = (uint8_t)state[i];
+    }
+}
+
+// --- Code decompression ----------------------------------------------------
+
+typedef struct {
+    uint8_t* data;
+    size_t len, cap;
+} Buf;
+
+static int buf_put(Buf* b, uint8_t c) {
+    if (b->len == b->cap) {
+        size_t cap = b->cap ? b->cap * 2 : 0x4000;
+        uint8_t* data = realloc(b->data, cap);
+        if (!data) return -1;
+        b->data = data;
+        b->cap = cap;
+    }
+    b->data[b->len++] = c;
+    return 0;
+}
+
+// shrinko8's old format: ":c:\0" + size(2, BE) + 2 pad, then table codes / escaped literals / back-references
+static const char* const OLD_CODE_TABLE[60] = {
+    "", "\n", " ", "0", "1", "2", "3", "4", "5", "6", "7", "8", "9",
+    "a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l", "m",
+    "n", "o", "p", "q", "r", "s", "t", "u", "v", "w", "x", "y", "z",
+    "!", "#", "%", "(", ")", "{", "}", "[", "]", "<", ">",
+    "+", "=", "/", "*", ":", ";", ".", ",", "~", "_",
+};
+
+// Trailing shim PICO-8 appends to old carts:
+// if(_update60)_update=function()_update60([)_update_buttons(]*)_update60()end
+#define LEGACY_HEAD "if(_update60)_update=function()_update60("
+#define LEGACY_TAIL ")_update60()end"
+#define LEGACY_FILL ")_update_buttons("
+
+static size_t clean_legacy_code(const uint8_t* code, size_t len) {
+    const uint8_t* nul = memchr(code, 0, len);
+    if (nul) len = nul - code;
+    size_t head = sizeof(LEGACY_HEAD) - 1, tail = sizeof(LEGACY_TAIL) - 1;
+    size_t window = len < 150 ? len : 150;
+    if (window < head + tail || memcmp(code + len - tail, LEGACY_TAIL, tail) != 0) return len;
+    // Leftmost match in the last 150 bytes, like the regex search
+    for (size_t start = len - window; start + head + tail <= len; start++) {
+        if (memcmp(code + start, LEGACY_HEAD, head) != 0) continue;
+        size_t i = start + head;
+        while (i < len - tail && strchr(LEGACY_FILL, code[i])) i++;
+        if (i == len - tail) return start;
+    }
+    return len;
+}
+
+static int decompress_old(const uint8_t* src, size_t src_len, Buf* out) {
+    size_t pos = 8;
+    while (pos < src_len) {
+        uint8_t ch = src[pos++];
+        if (ch == 0x00) {
+            if (pos >= src_len) break;
+            uint8_t literal = src[pos++];
+            if (literal == 0x00) break; // End of stream
+            if (buf_put(out, literal)) return CARTDEC_ERR_NOMEM;
+        } else if (ch <= 0x3b) {
+            for (const char* s = OLD_CODE_TABLE[ch]; *s; s++) {
+                if (buf_put(out, (uint8_t)*s)) return CARTDEC_ERR_NOMEM;
+            }
+        } else {
+            if (pos >= src_len) break;
+            uint8_t ch2 = src[pos++];
+            size_t count = (ch2 >> 4) + 2;
+            size_t offset = ((size_t)(ch - 0x3c) << 4) + (ch2 & 0xf);
+            size_t start = out->len;
+            for (size_t i = 0; i < count; i++) {
+                uint8_t c = (offset <= start && offset > 0) ? out->data[start - offset + i] : 0;
+                if (buf_put(out, c)) return CARTDEC_ERR_NOMEM;
+            }
+        }
+    }
+    out->len = clean_legacy_code(out->data, out->len);
+    return CARTDEC_OK;
+}
+
+// PXA (zepto8's decompressor): LSB-first bit stream of move-to-front literals and LZ blocks
+typedef struct {
+    const uint8_t* src;
+    size_t len, pos;
+    int bit;
+} BitReader;
+
+static inline int get_bit(BitReader* br) {
+    if (br->pos >= br->len) return 0;
+    int val = (br->src[br->pos] >> br->bit) & 1;
+    if (++br->bit == 8) {
+        br->bit = 0;
+        br->pos++;
+    }
+    return val;
+}
+
+static inline uint32_t get_bits(BitReader* br, int count) {
+    uint32_t val = 0;
+    for (int i = 0; i < count; i++) val |= (uint32_t)get_bit(br) << i;
+    return val;
+}
+
+static int decompress_pxa(const uint8_t* src, size_t src_len, Buf* out) {
+    size_t raw_len = ((size_t)src[4] << 8) | src[5];
+    out->data = malloc(raw_len ? raw_len : 1);
+    if (!out->data) return CARTDEC_ERR_NOMEM;
+    out->cap = raw_len ? raw_len : 1;
+
+    uint8_t mtf[256];
+    for (int i = 0; i < 256; i++) mtf[i] = (uint8_t)i;
+    BitReader br = {src, src_len, 8, 0};
+    uint8_t* dst = out->data;
+    size_t dest = 0;
+
+    while (dest < raw_len) {
+        if (get_bit(&br)) {
+            // Unary length prefix, then the move-to-front index: anything past 255 is not a byte
+            int nbits = 4;
+            while (get_bit(&br)) {
+                if (++nbits > 8) return CARTDEC_ERR_CODE;
+            }
+            uint32_t n = get_bits(&br, nbits) + (1u << nbits) - 16;
+            if (n > 255) return CARTDEC_ERR_CODE;
+            uint8_t ch = mtf[n];
+            memmove(mtf + 1, mtf, n);
+            mtf[0] = ch;
+            dst[dest++] = ch;
+        } else {
+            int nbits = get_bit(&br) ? (get_bit(&br) ? 5 : 10) : 15;
+            size_t offset = get_bits(&br, nbits) + 1;
+            if (nbits == 10 && offset == 1) {
+                // Raw block: bytes until a zero
+                uint8_t ch = (uint8_t)get_bits(&br, 8);
+                while (ch != 0 && dest < raw_len) {
+                    dst[dest++] = ch;
+                    ch = (uint8_t)get_bits(&br, 8);
+                }
+            } else {
+                size_t length = 3;
+                uint32_t n;
+                do {
+                    n = get_bits(&br, 3);
+                    length += n;
+                } while (n == 7 && br.pos < br.len);
+                for (size_t i = 0; i < length && dest < raw_len; i++, dest++) {
+                    dst[dest] = offset <= dest ? dst[dest - offset] : 0;
+                }
+            }
+        }
+    }
+    out->len = raw_len;
+    return CARTDEC_OK;
+}
+
+// --- Label -----------------------------------------------------------------
+
+// PICO-8 32 color palette (16 main + 16 secondary) as stored in labels: 6 bits per channel
+static const uint8_t PALETTE_6BPP[32][3] = {
+    {0x00, 0x00, 0x00}, {0x1C, 0x28, 0x50}, {0x7C, 0x24, 0x50}, {0x00, 0x84, 0x50},
+    {0xA8, 0x50, 0x34}, {0x5C, 0x54, 0x4C}, {0xC0, 0xC0, 0xC4}, {0xFC, 0xF0, 0xE8},
+    {0xFC, 0x00, 0x4C}, {0xFC, 0xA0, 0x00}, {0xFC, 0xEC, 0x24}, {0x00, 0xE4, 0x34},
+    {0x28, 0xAC, 0xFC}, {0x80, 0x74, 0x9C}, {0xFC, 0x74, 0xA8}, {0xFC, 0xCC, 0xA8},
+    {0x28, 0x18, 0x14}, {0x10, 0x1C, 0x34}, {0x40, 0x20, 0x34}, {0x10, 0x50, 0x58},
+    {0x74, 0x2C, 0x28}, {0x48, 0x30, 0x38}, {0xA0, 0x88, 0x78}, {0xF0, 0xEC, 0x7C},
+    {0xBC, 0x10, 0x50}, {0xFF, 0x6C, 0x24}, {0xA8, 0xE4, 0x2C}, {0x00, 0xB4, 0x40},
+    {0x04, 0x58, 0xB4}, {0x74, 0x44, 0x64}, {0xFF, 0x6C, 0x58}, {0xFF, 0x9C, 0x80},
+};
+
+// Exact 6-bit match first, nearest color otherwise
+static uint8_t closest_color(uint8_t r, uint8_t g, uint8_t b) {
+    int r6 = r & ~3, g6 = g & ~3, b6 = b & ~3;
+    for (int i = 0; i < 32; i++) {
+        if (PALETTE_6BPP[i][0] == r6 && PALETTE_6BPP[i][1] == g6 && PALETTE_6BPP[i][2] == b6) return (uint8_t)i;
+    }
+    int best = 0, best_dist = 0x7FFFFFFF;
+    for (int i = 0; i < 32; i++) {
+        int dr = PALETTE_6BPP[i][0] - r6, dg = PALETTE_6BPP[i][1] - g6, db = PALETTE_6BPP[i][2] - b6;
+        int dist = dr * dr + dg * dg + db * db;
+        if (dist < best_dist) {
+            best_dist = dist;
+            best = i;
+        }
+    }
+    return (uint8_t)best;
+}
+
+// Labels use few distinct colors: cache the last lookup instead of searching per pixel
+static void extract_label(const uint8_t* rgba, uint32_t width, uint8_t* label) {
+    uint32_t last_rgb = 0xFFFFFFFF;
+    uint8_t last_idx = 0;
+    for (int y = 0; y < CART_LABEL_SIZE; y++) {
+        const uint8_t* row = rgba + ((size_t)(24 + y) * width + 16) * 4;
+        for (int x = 0; x < CART_LABEL_SIZE; x++) {
+            const uint8_t* p = row + x * 4;
+            uint32_t rgb = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+            if (rgb != last_rgb) {
+                last_rgb = rgb;
+                last_idx = closest_color(p[0], p[1], p[2]);
+            }
+            label[y * CART_LABEL_SIZE + x] = last_idx;
+        }
+    }
+}
+
+// --- Decoder ---------------------------------------------------------------
+
+int cartdec_decode(const uint8_t* png, size_t png_len, CartData* cart) {
+    memset(cart, 0, offsetof(CartData, label));
+    uint8_t* rgba = NULL;
+    uint32_t w, h;
+    int err = png_decode_rgba(png, png_len, &rgba, &w, &h);
+    if (err) return err;
+    // The label sits at (16, 24); a standard cart is 160x205
+    if ((size_t)w * h < CART_ROM_SIZE || w < 16 + CART_LABEL_SIZE || h < 24 + CART_LABEL_SIZE) {
+        free(rgba);
+        return CARTDEC_ERR_SIZE;
+    }
+
+    // Two low bits per channel: B -> bits 0-1, G -> 2-3, R -> 4-5, A -> 6-7
+    uint8_t stego[STEGO_SIZE] = {0};
+    size_t stego_len = (size_t)w * h < STEGO_SIZE ? (size_t)w * h : STEGO_SIZE;
+    for (size_t i = 0; i < stego_len; i++) {
+        const uint8_t* p = rgba + i * 4;
+        stego[i] = (p[2] & 3) | ((p[1] & 3) << 2) | ((p[0] & 3) << 4) | ((p[3] & 3) << 6);
+    }
+    extract_label(rgba, w, cart->label);
+    free(rgba);
+
+    if (stego_len == STEGO_SIZE) {
+        static const uint8_t zero_hash[20];
+        const uint8_t* stored = stego + STEGO_HASH_ADDR;
+        if (memcmp(stored, zero_hash, 20) != 0) {
+            uint8_t digest[20];
+            sha1(stego, CART_ROM_SIZE, digest);
+            if (memcmp(digest, stored, 20) != 0) return CARTDEC_ERR_HASH;
+        }
+    }
+    memcpy(cart->rom, stego, CART_ROM_SIZE);
+
+    const uint8_t* code = cart->rom + CART_CODE_ADDR;
+    size_t code_size = CART_ROM_SIZE - CART_CODE_ADDR;
+    Buf out = {0};
+    if (memcmp(code, ":c:\0", 4) == 0) {
+        cart->code_format = CARTDEC_CODE_OLD;
+        err = decompress_old(code, code_size, &out);
+    } else if (memcmp(code, "\0pxa", 4) == 0) {
+        cart->code_format = CARTDEC_CODE_PXA;
+        err = decompress_pxa(code, code_size, &out);
+    } else {
+        // Raw code ends at the first NUL
+        cart->code_format = CARTDEC_CODE_RAW;
+        const uint8_t* nul = memchr(code, 0, code_size);
+        out.len = nul ? (size_t)(nul - code) : code_size;
+        out.data = malloc(out.len ? out.len : 1);
+        if (out.data) memcpy(out.data, code, out.len);
+        else err = CARTDEC_ERR_NOMEM;
+    }
+    if (err) {
+        free(out.data);
+        return err;
+    }
+    cart->code = out.data;
+    cart->code_len = out.len;
+    return CARTDEC_OK;
+}
+
+int cartdec_decode_file(const char* path, CartData* cart) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return CARTDEC_ERR_IO;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size <= 0) {
+        fclose(f);
+        return CARTDEC_ERR_IO;
+    }
+    uint8_t* data = malloc(size);
+    if (!data) {
+        fclose(f);
+        return CARTDEC_ERR_NOMEM;
+    }
+    size_t got = fread(data, 1, size, f);
+    fclose(f);
+    int err = got == (size_t)size ? cartdec_decode(data, got, cart) : CARTDEC_ERR_IO;
+    free(data);
+    return err;
+}
+
+void cartdec_free(CartData* cart) {
+    free(cart->code);
+    cart->code = NULL;
+    cart->code_len = 0;
+}
+
+const char* cartdec_strerror(int err) {
+    switch (err) {
+    case CARTDEC_OK: return "ok";
+    case CARTDEC_ERR_PNG: return "unsupported or corrupt PNG";
+    case CARTDEC_ERR_SIZE: return "image too small for a cart";
+    case CARTDEC_ERR_HASH: return "integrity check failed (SHA1 mismatch)";
+    case CARTDEC_ERR_IO: return "read/write error";
+    case CARTDEC_ERR_NOMEM: return "out of memory";
+    case CARTDEC_ERR_CODE: return "malformed compressed code";
+    }
+    return "unknown error";
+}
+
+// --- .p8 writer ------------------------------------------------------------
+
+// k_charset from shrinko8's pico_defs.py, UTF-8 encoded. NUL maps to nothing.
+static const char* const P8SCII[256] = {
+    "", "¹", "²", "³", "⁴", "⁵", "⁶", "⁷", "⁸", "\t", "\n", "ᵇ", "ᶜ", "\r", "ᵉ", "ᶠ",
+    "▮", "■", "□", "⁙", "⁘", "‖", "◀", "▶", "「", "」", "¥", "•", "、", "。", "゛", "゜",
+    " ", "!", "\"", "#", "$", "%", "&", "'", "(", ")", "*", "+", ",", "-", ".", "/",
+    "0", "1", "2", "3", "4", "5", "6", "7", "8", "9", ":", ";", "<", "=", ">", "?",
+    "@", "A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L", "M", "N", "O",
+    "P", "Q", "R", "S", "T", "U", "V", "W", "X", "Y", "Z", "[", "\\", "]", "^", "_",
+    "`", "a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l", "m", "n", "o",
+    "p", "q", "r", "s", "t", "u", "v", "w", "x", "y", "z", "{", "|", "}", "~", "○",
+    "█", "▒", "🐱", "⬇️", "░", "✽", "●", "♥", "☉", "웃", "⌂", "⬅️", "😐", "♪", "🅾️", "◆",
+    "…", "➡️", "★", "⧗", "⬆️", "ˇ", "∧", "❎", "▤", "▥", "あ", "い", "う", "え", "お", "か",
+    "き", "く", "け", "こ", "さ", "し", "す", "せ", "そ", "た", "ち", "つ", "て", "と", "な", "に",
+    "ぬ", "ね", "の", "は", "ひ", "ふ", "へ", "ほ", "ま", "み", "む", "め", "も", "や", "ゆ", "よ",
+    "ら", "り", "る", "れ", "ろ", "わ", "を", "ん", "っ", "ゃ", "ゅ", "ょ", "ア", "イ", "ウ", "エ",
+    "オ", "カ", "キ", "ク", "ケ", "コ", "サ", "シ", "ス", "セ", "ソ", "タ", "チ", "ツ", "テ", "ト",
+    "ナ", "ニ", "ヌ", "ネ", "ノ", "ハ", "ヒ", "フ", "ヘ", "ホ", "マ", "ミ", "ム", "メ", "モ", "ヤ",
+    "ユ", "ヨ", "ラ", "リ", "ル", "レ", "ロ", "ワ", "ヲ", "ン", "ッ", "ャ", "ュ", "ョ", "◜", "◝",
+};
+
+size_t cartdec_code_to_utf8(const uint8_t* code, size_t len, char* out) {
+    char* p = out;
+    for (size_t i = 0; i < len; i++) {
+        const char* s = P8SCII[code[i]];
+        while (*s) *p++ = *s++;
+    }
+    return p - out;
+}
+
+static const char HEX[] = "0123456789abcdef";
+
+// Hex rows for a byte region. Returns the number of leading rows to keep (0 if all empty).
+static int last_nonzero_row(const uint8_t* mem, int rows, int row_bytes) {
+    int last = 0;
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < row_bytes; x++) {
+            if (mem[y * row_bytes + x]) {
+                last = y + 1;
+                break;
+            }
+        }
+    }
+    return last;
+}
+
+static void write_gfx(const uint8_t* rom, FILE* f) {
+    int rows = last_nonzero_row(rom + MEM_SPRITES_ADDR, 128, 64);
+    if (!rows) return;
+    fputs("__gfx__\n", f);
+    char line[129];
+    line[128] = '\n';
+    for (int y = 0; y < rows; y++) {
+        const uint8_t* row = rom + MEM_SPRITES_ADDR + y * 64;
+        for (int x = 0; x < 64; x++) {
+            line[x * 2] = HEX[row[x] & 0xF];
+            line[x * 2 + 1] = HEX[row[x] >> 4];
+        }
+        fwrite(line, 1, sizeof(line), f);
+    }
+}
+
+static void write_label(const uint8_t* label, FILE* f) {
+    if (!last_nonzero_row(label, CART_LABEL_SIZE, CART_LABEL_SIZE)) return;
+    fputs("__label__\n", f);
+    // Extended nybbles: 0-15 = '0'-'f', 16-31 = 'g'-'v'
+    char line[CART_LABEL_SIZE + 1];
+    line[CART_LABEL_SIZE] = '\n';
+    for (int y = 0; y < CART_LABEL_SIZE; y++) {
+        for (int x = 0; x < CART_LABEL_SIZE; x++) {
+            uint8_t c = label[y * CART_LABEL_SIZE + x];
+            line[x] = c < 16 ? HEX[c] : (char)('g' + (c - 16));
+        }
+        fwrite(line, 1, sizeof(line), f);
+    }
+}
+
+static void write_hex_rows(const char* section, const uint8_t* mem, int rows, FILE* f) {
+    fputs(section, f);
+    char line[257];
+    line[256] = '\n';
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < 128; x++) {
+            line[x * 2] = HEX[mem[y * 128 + x] >> 4];
+            line[x * 2 + 1] = HEX[mem[y * 128 + x] & 0xF];
+        }
+        fwrite(line, 1, sizeof(line), f);
+    }
+}
+
+static void write_gff(const uint8_t* rom, FILE* f) {
+    int rows = last_nonzero_row(rom + MEM_FLAG_ADDR, 2, 128);
+    if (rows) write_hex_rows("__gff__\n", rom + MEM_FLAG_ADDR, rows, f);
+}
+
+static void write_map(const uint8_t* rom, FILE* f) {
+    // Only the top 32 rows; the bottom half is shared with gfx
+    int rows = last_nonzero_row(rom + MEM_MAP_ADDR, 32, 128);
+    if (rows) write_hex_rows("__map__\n", rom + MEM_MAP_ADDR, rows, f);
+}
+
+static void write_sfx(const uint8_t* rom, FILE* f) {
+    // 64 x 68 bytes: 32 notes x 2 bytes, then editor mode, speed, loop start, loop end
+    char lines[64][4 * 2 + 32 * 5 + 1];
+    int count = 0;
+    for (int i = 0; i < 64; i++) {
+        const uint8_t* sfx = rom + MEM_SFX_ADDR + i * 68;
+        char* p = lines[i];
+        for (int j = 0; j < 4; j++) {
+            *p++ = HEX[sfx[64 + j] >> 4];
+            *p++ = HEX[sfx[64 + j] & 0xF];
+        }
+        int empty = 1;
+        for (int n = 0; n < 32; n++) {
+            uint16_t note = sfx[n * 2] | (sfx[n * 2 + 1] << 8);
+            int waveform = ((note >> 6) & 0x7) | (((note >> 15) & 0x1) << 3);
+            *p++ = HEX[(note >> 4) & 0x3];
+            *p++ = HEX[note & 0xF];
+            *p++ = HEX[waveform];
+            *p++ = HEX[(note >> 9) & 0x7];
+            *p++ = HEX[(note >> 12) & 0x7];
+            if (note) empty = 0;
+        }
+        *p = '\n';
+        int default_info = i == 0 ? memcmp(lines[i], "00010000", 8) == 0 : memcmp(lines[i], "00100000", 8) == 0;
+        if (!empty || !default_info) count = i + 1;
+    }
+    if (!count) return;
+    fputs("__sfx__\n", f);
+    for (int i = 0; i < count; i++) fwrite(lines[i], 1, sizeof(lines[i]), f);
+}
+
+static void write_music(const uint8_t* rom, FILE* f) {
+    // 64 patterns x 4 channels: bit 7 = flag, bits 0-6 = sfx (0x41-0x44 = unused channel)
+    char lines[64][2 + 1 + 8 + 1];
+    int count = 0;
+    for (int i = 0; i < 64; i++) {
+        const uint8_t* pattern = rom + MEM_MUSIC_ADDR + i * 4;
+        int flags = 0, is_default = 1;
+        char* p = lines[i] + 3;
+        for (int ch = 0; ch < 4; ch++) {
+            if (pattern[ch] & 0x80) flags |= 1 << ch;
+            if (pattern[ch] != 0x41 + ch) is_default = 0;
+            *p++ = HEX[(pattern[ch] & 0x7F) >> 4];
+            *p++ = HEX[pattern[ch] & 0xF];
+        }
+        lines[i][0] = HEX[flags >> 4];
+        lines[i][1] = HEX[flags & 0xF];
+        lines[i][2] = ' ';
+        *p = '\n';
+        if (!is_default) count = i + 1;
+    }
+    if (!count) return;
+    fputs("__music__\n", f);
+    for (int i = 0; i < count; i++) fwrite(lines[i], 1, sizeof(lines[i]), f);
+}
+
+int cartdec_write_p8(const CartData* cart, FILE* f) {
+    fputs("pico-8 cartridge // http://www.pico-8.com\nversion 43\n\n__lua__\n", f);
+    char* utf8 = malloc(cart->code_len * CARTDEC_UTF8_MAX + 1);
+    if (!utf8) return CARTDEC_ERR_NOMEM;
+    size_t utf8_len = cartdec_code_to_utf8(cart->code, cart->code_len, utf8);
+    fwrite(utf8, 1, utf8_len, f);
+    free(utf8);
+    fputc('\n', f);
+    write_gfx(cart->rom, f);
+    write_label(cart->label, f);
+    write_gff(cart->rom, f);
+    write_map(cart->rom, f);
+    write_sfx(cart->rom, f);
+    write_music(cart->rom, f);
+    return ferror(f) ? CARTDEC_ERR_IO : CARTDEC_OK;
+}
@@ -0,0 +1,55 @@
+// PICO-8 .p8.png cart decoder: PNG bytes in, ROM / Lua code / label out.
+// Native port of frontend/pico_extractor.gd, used by the cartdec CLI (cartdec_cli.c).
+// Build: gcc -O3 -c cartdec.c (link with -lz)
+#ifndef CARTDEC_H
+#define CARTDEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define CART_ROM_SIZE 0x8000   // Steganographic payload: gfx/map/flags/music/sfx + code
+#define CART_CODE_ADDR 0x4300  // Start of the (compressed) code section
+#define CART_LABEL_SIZE 128    // Label is 128x128, read from the PNG at (16, 24)
+
+enum {
+    CARTDEC_CODE_RAW = 0,
+    CARTDEC_CODE_OLD,          // ":c:\0" pre-0.2.0 compression
+    CARTDEC_CODE_PXA,          // "\0pxa" 0.2.0+ compression
+};
+
+enum {
+    CARTDEC_OK = 0,
+    CARTDEC_ERR_PNG,           // Not a PNG we can read (8 bit RGB/RGBA/palette, not interlaced)
+    CARTDEC_ERR_SIZE,          // Image too small to hold a cart
+    CARTDEC_ERR_HASH,          // SHA1 at 0x8006 doesn't match the ROM
+    CARTDEC_ERR_IO,
+    CARTDEC_ERR_NOMEM,
+    CARTDEC_ERR_CODE,          // Compressed code section is malformed
+};
+
+typedef struct {
+    uint8_t rom[CART_ROM_SIZE];
+    uint8_t* code;             // Decompressed Lua in P8SCII (malloc'd, not NUL terminated)
+    size_t code_len;
+    int code_format;           // CARTDEC_CODE_*
+    uint8_t label[CART_LABEL_SIZE * CART_LABEL_SIZE]; // Palette indices 0-31 (16+ = secondary palette)
+} CartData;
+
+// Decode a .p8.png held in memory. On success cart->code must be released with cartdec_free.
+int cartdec_decode(const uint8_t* png, size_t png_len, CartData* cart);
+int cartdec_decode_file(const char* path, CartData* cart);
+void cartdec_free(CartData* cart);
+
+// Longest UTF-8 sequence one P8SCII character maps to ("🅾️": U+1F17E + U+FE0F)
+#define CARTDEC_UTF8_MAX 7
+
+// P8SCII -> UTF-8 (NUL bytes are dropped). Returns bytes written; out needs CARTDEC_UTF8_MAX * len bytes.
+size_t cartdec_code_to_utf8(const uint8_t* code, size_t len, char* out);
+
+// Write the cart as a text .p8 (same sections and layout as pico_extractor.gd)
+int cartdec_write_p8(const CartData* cart, FILE* f);
+
+const char* cartdec_strerror(int err);
+
+#endif
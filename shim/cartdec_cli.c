@@ -0,0 +1,297 @@
+// cartdec: convert .p8.png carts to .p8 text carts, in parallel.
+// Build: gcc -O3 -pthread -o cartdec cartdec_cli.c cartdec.c -lz
+// Usage: ./cartdec [-j jobs] [-o outdir] [-f] <cart.p8.png | dir>...
+//        ./cartdec --bench [-j jobs] [-n rounds] <cart.p8.png | dir>...
+// Directories (e.g. a bbs/ cache) are searched recursively for *.p8.png. Without -o each .p8 is written
+// next to its source; with -o the tree is mirrored under outdir. Up-to-date outputs are skipped unless -f.
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <ftw.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "cartdec.h"
+
+#define CART_SUFFIX ".p8.png"
+#define DEFAULT_BENCH_ROUNDS 5
+
+typedef struct {
+    char* src;
+    char* dst;
+    uint8_t* png;      // Bench mode: file preloaded so only decoding is timed
+    size_t png_len;
+} Job;
+
+static Job* jobs = NULL;
+static size_t job_count = 0, job_cap = 0;
+static atomic_size_t next_job;
+static atomic_int converted, skipped, failed;
+
+static const char* out_dir = NULL;
+static size_t root_len = 0; // Length of the directory argument currently being walked
+static int force = 0;
+static int bench_rounds = 0;
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int has_suffix(const char* s, const char* suffix) {
+    size_t n = strlen(s), m = strlen(suffix);
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+// foo.p8.png -> foo.p8 (anything else just gets .p8 appended), relative to -o when given
+static char* output_path(const char* src, size_t rel_start) {
+    const char* rel = out_dir ? src + rel_start : src;
+    while (out_dir && *rel == '/') rel++;
+    size_t len = strlen(rel);
+    if (has_suffix(rel, CART_SUFFIX)) len -= strlen(".png");
+    char* dst;
+    if (out_dir) {
+        if (asprintf(&dst, "%s/%.*s%s", out_dir, (int)len, rel, has_suffix(rel, CART_SUFFIX) ? "" : ".p8") < 0) return NULL;
+    } else {
+        if (asprintf(&dst, "%.*s%s", (int)len, rel, has_suffix(rel, CART_SUFFIX) ? "" : ".p8") < 0) return NULL;
+    }
+    return dst;
+}
+
+static void add_job(const char* src, size_t rel_start) {
+    if (job_count == job_cap) {
+        job_cap = job_cap ? job_cap * 2 : 256;
+        jobs = realloc(jobs, job_cap * sizeof(Job));
+        if (!jobs) {
+            perror("cartdec");
+            exit(1);
+        }
+    }
+    Job* job = &jobs[job_count++];
+    memset(job, 0, sizeof(*job));
+    job->src = strdup(src);
+    job->dst = output_path(src, rel_start);
+}
+
+static int walk_entry(const char* path, const struct stat* st, int type, struct FTW* ftw) {
+    (void)st;
+    (void)ftw;
+    if (type == FTW_F && has_suffix(path, CART_SUFFIX)) add_job(path, root_len);
+    return 0;
+}
+
+static int mkdir_parents(const char* path) {
+    char* tmp = strdup(path);
+    for (char* p = tmp + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(tmp, 0755) != 0 && errno != EEXIST) {
+            free(tmp);
+            return -1;
+        }
+        *p = '/';
+    }
+    free(tmp);
+    return 0;
+}
+
+static int up_to_date(const Job* job) {
+    struct stat src_st, dst_st;
+    if (stat(job->src, &src_st) != 0 || stat(job->dst, &dst_st) != 0) return 0;
+    return dst_st.st_mtim.tv_sec > src_st.st_mtim.tv_sec ||
+           (dst_st.st_mtim.tv_sec == src_st.st_mtim.tv_sec && dst_st.st_mtim.tv_nsec >= src_st.st_mtim.tv_nsec);
+}
+
+// Write to a temporary name and rename, so a reader never sees a half written cart
+static int convert(const Job* job) {
+    CartData* cart = malloc(sizeof(CartData));
+    if (!cart) return CARTDEC_ERR_NOMEM;
+    int err = cartdec_decode_file(job->src, cart);
+    if (err) {
+        free(cart);
+        return err;
+    }
+    char* tmp = NULL;
+    if (mkdir_parents(job->dst) != 0 || asprintf(&tmp, "%s.tmp%ld", job->dst, (long)gettid()) < 0) {
+        err = CARTDEC_ERR_IO;
+    } else {
+        FILE* f = fopen(tmp, "wb");
+        if (!f) {
+            err = CARTDEC_ERR_IO;
+        } else {
+            err = cartdec_write_p8(cart, f);
+            if (fclose(f) != 0 && !err) err = CARTDEC_ERR_IO;
+            if (!err && rename(tmp, job->dst) != 0) err = CARTDEC_ERR_IO;
+            if (err) unlink(tmp);
+        }
+    }
+    free(tmp);
+    cartdec_free(cart);
+    free(cart);
+    return err;
+}
+
+static void* convert_worker(void* arg) {
+    (void)arg;
+    for (;;) {
+        size_t i = atomic_fetch_add(&next_job, 1);
+        if (i >= job_count) break;
+        const Job* job = &jobs[i];
+        if (!force && up_to_date(job)) {
+            atomic_fetch_add(&skipped, 1);
+            continue;
+        }
+        int err = convert(job);
+        if (err) {
+            fprintf(stderr, "%s: %s\n", job->src, cartdec_strerror(err));
+            atomic_fetch_add(&failed, 1);
+        } else {
+            atomic_fetch_add(&converted, 1);
+        }
+    }
+    return NULL;
+}
+
+static void* bench_worker(void* arg) {
+    (void)arg;
+    CartData* cart = malloc(sizeof(CartData));
+    if (!cart) return NULL;
+    size_t total = job_count * bench_rounds;
+    for (;;) {
+        size_t i = atomic_fetch_add(&next_job, 1);
+        if (i >= total) break;
+        const Job* job = &jobs[i % job_count];
+        if (cartdec_decode(job->png, job->png_len, cart) == CARTDEC_OK) {
+            // Include the text conversion, that's what a .p8 export costs on top of decoding
+            FILE* f = fopen("/dev/null", "wb");
+            if (f) {
+                cartdec_write_p8(cart, f);
+                fclose(f);
+            }
+            cartdec_free(cart);
+            atomic_fetch_add(&converted, 1);
+        } else {
+            atomic_fetch_add(&failed, 1);
+        }
+    }
+    free(cart);
+    return NULL;
+}
+
+static double run_workers(void* (*worker)(void*), int threads) {
+    pthread_t* tids = calloc(threads, sizeof(pthread_t));
+    atomic_store(&next_job, 0);
+    uint64_t start = now_ns();
+    int started = 0;
+    for (; started < threads; started++) {
+        if (pthread_create(&tids[started], NULL, worker, NULL) != 0) break;
+    }
+    if (started == 0) worker(NULL);
+    for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+    free(tids);
+    return (now_ns() - start) / 1e9;
+}
+
+static int preload(Job* job) {
+    FILE* f = fopen(job->src, "rb");
+    if (!f) return -1;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    job->png = size > 0 ? malloc(size) : NULL;
+    job->png_len = job->png ? fread(job->png, 1, size, f) : 0;
+    fclose(f);
+    return job->png_len > 0 ? 0 : -1;
+}
+
+static void bench(int threads) {
+    size_t bytes = 0;
+    for (size_t i = 0; i < job_count; i++) {
+        if (preload(&jobs[i]) != 0) {
+            fprintf(stderr, "%s: %s\n", jobs[i].src, cartdec_strerror(CARTDEC_ERR_IO));
+            exit(1);
+        }
+        bytes += jobs[i].png_len;
+    }
+    printf("cartdec bench: %zu carts (%.1f MB), %d rounds\n", job_count, bytes / (1024.0 * 1024.0), bench_rounds);
+    int counts[2] = {1, threads};
+    for (int c = 0; c < (threads > 1 ? 2 : 1); c++) {
+        atomic_store(&converted, 0);
+        atomic_store(&failed, 0);
+        double elapsed = run_workers(bench_worker, counts[c]);
+        int ok = atomic_load(&converted);
+        printf("  %2d thread(s) %10.1f carts/s %8.1f MB/s %8.3f ms/cart  (%d failed)\n",
+               counts[c], ok / elapsed, bytes * (double)bench_rounds / elapsed / (1024.0 * 1024.0),
+               elapsed * 1000.0 * counts[c] / (ok + atomic_load(&failed)), atomic_load(&failed) / bench_rounds);
+    }
+}
+
+static void usage() {
+    fprintf(stderr,
+            "Usage: cartdec [-j jobs] [-o outdir] [-f] <cart.p8.png | dir>...\n"
+            "       cartdec --bench [-j jobs] [-n rounds] <cart.p8.png | dir>...\n");
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) threads = 1;
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        const char* opt = argv[arg];
+        if (strcmp(opt, "--bench") == 0) {
+            if (!bench_rounds) bench_rounds = DEFAULT_BENCH_ROUNDS;
+        } else if (strcmp(opt, "-f") == 0) {
+            force = 1;
+        } else if (strcmp(opt, "-j") == 0 && arg + 1 < argc) {
+            threads = atoi(argv[++arg]);
+            if (threads < 1) threads = 1;
+        } else if (strcmp(opt, "-n") == 0 && arg + 1 < argc) {
+            bench_rounds = atoi(argv[++arg]);
+            if (bench_rounds < 1) bench_rounds = 1;
+        } else if (strcmp(opt, "-o") == 0 && arg + 1 < argc) {
+            out_dir = argv[++arg];
+        } else {
+            usage();
+        }
+    }
+    if (arg >= argc) usage();
+
+    for (; arg < argc; arg++) {
+        struct stat st;
+        if (stat(argv[arg], &st) != 0) {
+            fprintf(stderr, "%s: %s\n", argv[arg], strerror(errno));
+            continue;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            root_len = strlen(argv[arg]);
+            nftw(argv[arg], walk_entry, 32, FTW_PHYS);
+        } else {
+            // Single files keep only their name under -o
+            const char* slash = strrchr(argv[arg], '/');
+            add_job(argv[arg], slash ? (size_t)(slash - argv[arg]) : 0);
+        }
+    }
+    if (job_count == 0) {
+        fprintf(stderr, "cartdec: no carts found\n");
+        return 1;
+    }
+    if ((size_t)threads > job_count && !bench_rounds) threads = (int)job_count;
+
+    if (bench_rounds) {
+        bench(threads);
+        return 0;
+    }
+
+    double elapsed = run_workers(convert_worker, threads);
+    int done = atomic_load(&converted);
+    printf("cartdec: %d converted, %d up to date, %d failed in %.2f s (%.1f carts/s, %d threads)\n",
+           done, atomic_load(&skipped), atomic_load(&failed), elapsed, elapsed > 0 ? done / elapsed : 0.0, threads);
+    return atomic_load(&failed) ? 1 : 0;
+}
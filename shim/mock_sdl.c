@@ -0,0 +1,88 @@
+// Stand-in for libSDL2 so picoshim.so can run on a host without PICO-8 (see shim_bench.c).
+// Only what the shim forwards to or calls: one 128x128 XRGB8888 window surface, no events, no audio device.
+// Build: gcc -O2 -shared -fPIC -o libmocksdl.so mock_sdl.c
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <time.h>
+#include <SDL2/SDL.h>
+
+struct SDL_Window {
+    SDL_Surface* surface;
+};
+
+static SDL_PixelFormat mock_format;
+static uint32_t mock_pixels[128 * 128];
+static SDL_Surface mock_surface;
+static struct SDL_Window mock_window;
+
+DECLSPEC int SDLCALL SDL_Init(Uint32 flags) {
+    (void)flags;
+    return 0;
+}
+
+DECLSPEC SDL_Window* SDLCALL SDL_CreateWindow(const char* title, int x, int y, int w, int h, Uint32 flags) {
+    (void)title; (void)x; (void)y; (void)w; (void)h; (void)flags;
+    mock_format.format = SDL_PIXELFORMAT_RGB888;
+    mock_surface.format = &mock_format;
+    mock_surface.w = 128;
+    mock_surface.h = 128;
+    mock_surface.pitch = 128 * 4;
+    mock_surface.pixels = mock_pixels;
+    mock_window.surface = &mock_surface;
+    return &mock_window;
+}
+
+DECLSPEC SDL_Surface* SDLCALL SDL_GetWindowSurface(SDL_Window* window) {
+    return window ? window->surface : NULL;
+}
+
+DECLSPEC int SDLCALL SDL_UpdateWindowSurface(SDL_Window* window) {
+    (void)window;
+    return 0;
+}
+
+DECLSPEC void SDLCALL SDL_RenderPresent(SDL_Renderer* renderer) {
+    (void)renderer;
+}
+
+DECLSPEC int SDLCALL SDL_PollEvent(SDL_Event* event) {
+    (void)event;
+    return 0;
+}
+
+DECLSPEC SDL_Keymod SDLCALL SDL_GetModState(void) {
+    return KMOD_NONE;
+}
+
+DECLSPEC const char* SDLCALL SDL_GetPixelFormatName(Uint32 format) {
+    return format == SDL_PIXELFORMAT_RGB888 ? "SDL_PIXELFORMAT_RGB888" : "SDL_PIXELFORMAT_UNKNOWN";
+}
+
+DECLSPEC Uint32 SDLCALL SDL_GetTicks(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (Uint32)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+DECLSPEC void SDLCALL SDL_Delay(Uint32 ms) {
+    struct timespec ts = {ms / 1000, (ms % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+}
+
+// No audio device: PICO_AUDIO_DIRECT=1 still works, the shim drives the callback itself
+DECLSPEC int SDLCALL SDL_OpenAudio(SDL_AudioSpec* desired, SDL_AudioSpec* obtained) {
+    (void)desired;
+    (void)obtained;
+    return -1;
+}
+
+DECLSPEC void SDLCALL SDL_PauseAudio(int pause_on) {
+    (void)pause_on;
+}
+
+DECLSPEC void SDLCALL SDL_LockAudio(void) {
+}
+
+DECLSPEC void SDLCALL SDL_UnlockAudio(void) {
+}
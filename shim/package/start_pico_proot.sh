@@ -3,24 +3,40 @@ ROOTFS_LOCATION=$(pwd)/rootfs
 
 echo "Host script started at $(date)"
 
+# Boot phase timing, seconds since device boot (the frontend and shim log their own phases)
+boot_mark() {
+    read up _ < /proc/uptime
+    echo "boot: $1 at ${up}s"
+}
+boot_mark "script start"
+
 # Ensure tmp directory exists
 LD_LIBRARY_PATH=. ./busybox mkdir -p tmp
 
 # Create PICO-8 pipes on HOST filesystem (bound to /tmp in proot) if they don't exist
 [ -p tmp/pico8.vid ] || LD_LIBRARY_PATH=. ./busybox mkfifo tmp/pico8.vid
 [ -p tmp/pico8.in ] || LD_LIBRARY_PATH=. ./busybox mkfifo tmp/pico8.in
-chmod 666 tmp/pico8.vid tmp/pico8.in
+[ -p tmp/pico8.aud ] || LD_LIBRARY_PATH=. ./busybox mkfifo tmp/pico8.aud
+chmod 666 tmp/pico8.vid tmp/pico8.in tmp/pico8.aud
 
 
-# Running pulsar.sh in background, logging to PUBLIC log directory
 LOG_DIR="/sdcard/Documents/pico8/logs"
 mkdir -p "$LOG_DIR"
-LD_LIBRARY_PATH=. ./busybox ash pulsar.sh > "$LOG_DIR/pulse.log" 2>&1 &
 
+if [ "$PICO_AUDIO_DIRECT" = "1" ]; then
+    # The shim writes PCM straight to tmp/pico8.aud, no PulseAudio needed.
+    # tmp/pulse only has to exist for the FD 7 bind below.
+    echo "Direct audio: skipping PulseAudio"
+    mkdir -p tmp/pulse
+else
+    # Running pulsar.sh in background, logging to PUBLIC log directory
+    LD_LIBRARY_PATH=. ./busybox ash pulsar.sh > "$LOG_DIR/pulse.log" 2>&1 &
 
-while [ ! -d tmp/pulse ]; do
-    sleep 0.02
-done
+    while [ ! -d tmp/pulse ]; do
+        sleep 0.01
+    done
+    boot_mark "pulse ready"
+fi
 
 # Open File Descriptor 9 to current directory (package)
 # This allows proot to access the loader via /proc/self/fd/9/prootlb regardless of CWD.
@@ -41,9 +57,14 @@ exec 8< ./ptmp
 
 PROOT_TMP_DIR="/proc/self/fd/8"
 # Patch proot binary to use FD path for loader (23 chars target + 22 slashes padding = 45 chars total)
-LD_LIBRARY_PATH=. ./busybox sed -i 's|/data/data/com.termux/files/usr/libexec/proot|///////////////////////proc/self/fd/9/prootlb|g' ./proot
+# Rewriting the binary costs a full read + write, so it's done once; the stamp is redone if proot is replaced
+if [ ! -f .proot_patched ] || [ ./proot -nt .proot_patched ]; then
+    LD_LIBRARY_PATH=. ./busybox sed -i 's|/data/data/com.termux/files/usr/libexec/proot|///////////////////////proc/self/fd/9/prootlb|g' ./proot && touch .proot_patched
+    echo "Patched proot loader path"
+fi
 
 echo "Using FD 8 strategy for tmp: $PROOT_TMP_DIR"
+boot_mark "proot exec"
 
 LD_LIBRARY_PATH=. PROOT_TMP_DIR=$PROOT_TMP_DIR ./proot \
     -p \
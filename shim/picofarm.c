@@ -0,0 +1,383 @@
+// picofarm: run carts in many headless PICO-8 instances at once and collect their frames and state bytes.
+// Build: gcc -O3 -pthread -o picofarm picofarm.c
+// Usage: ./picofarm [-j slots] [-t seconds] [-o outdir] [-s picoshim.so] [-p pico8_64] <cart>...
+// Each cart gets its own instance with its own channels (PICO_CHANNEL_PREFIX) and -home, so nothing is
+// shared between slots and throughput scales with cores. Per cart it reports frames received, time to
+// first frame, the last NavState/MasterState/Volume bytes and how the instance ended; with -o the last
+// frame is written as <outdir>/<cart>.ppm (thumbnails). Logs of carts that failed stay in /tmp/picofarm.*.
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <libgen.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// Wire format, see shim.c
+#define SYNC "PICO8SYNC"
+#define SYNC_SIZE 9
+#define TYPE_INDEX 9
+#define META_INDEX 11
+#define META_SIZE 3
+#define PAYLOAD_OFFSET 22
+#define FB_SIZE 128
+#define PIXEL_SIZE (FB_SIZE * FB_SIZE * 4)
+#define PALETTE_SIZE (16 * 3)
+#define INDEXED_PIXEL_SIZE (FB_SIZE * FB_SIZE / 2)
+#define ROW_MASK_SIZE 16
+#define SHM_DOORBELL_SIZE 8
+#define TELEMETRY_SIZE 32
+#define READY_SIZE 20
+
+#define IN_PACKET_SIZE 16
+#define EVENT_VIDMODE 4
+#define ENCODING_INDEXED 1 // ~8KB per frame; no delta/shm flags, so every frame is complete
+
+#define DEFAULT_SECONDS 10
+#define READ_SIZE (PAYLOAD_OFFSET + PIXEL_SIZE)
+#define STOP_GRACE_MS 500
+
+typedef struct {
+    const char* cart;
+    unsigned long frames;
+    double first_frame_ms; // From spawn, -1 if none arrived
+    uint8_t meta[META_SIZE];
+    int exited_early;      // Instance died before the time was up
+    int status;            // waitpid status
+    uint8_t rgb[FB_SIZE * FB_SIZE * 3];
+} Job;
+
+static Job* jobs = NULL;
+static int job_count = 0;
+static atomic_int next_job;
+static atomic_ulong total_frames;
+
+static const char* shim_path = "./picoshim.so";
+static const char* pico8_path = "../pico8_64";
+static const char* out_dir = NULL;
+static char work_dir[] = "/tmp/picofarm.XXXXXX";
+static int seconds = DEFAULT_SECONDS;
+
+static uint64_t now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000ull + ts.tv_nsec / 1000000;
+}
+
+// Size of the packet at p, -1 if the type is unknown, 0 if more bytes are needed to tell
+static long packet_size(const uint8_t* p, size_t available) {
+    size_t rows = 0;
+    switch (p[TYPE_INDEX]) {
+    case '_': return PAYLOAD_OFFSET + PIXEL_SIZE;
+    case 'I': return PAYLOAD_OFFSET + PALETTE_SIZE + INDEXED_PIXEL_SIZE;
+    case 'K': return PAYLOAD_OFFSET;
+    case 'S': return PAYLOAD_OFFSET + SHM_DOORBELL_SIZE;
+    case 'T': return PAYLOAD_OFFSET + TELEMETRY_SIZE;
+    case 'R': return PAYLOAD_OFFSET + READY_SIZE;
+    case 'd':
+    case 'i': {
+        size_t mask_at = PAYLOAD_OFFSET + (p[TYPE_INDEX] == 'i' ? PALETTE_SIZE : 0);
+        if (available < mask_at + ROW_MASK_SIZE) return 0;
+        for (int i = 0; i < ROW_MASK_SIZE; i++) rows += __builtin_popcount(p[mask_at + i]);
+        return mask_at + ROW_MASK_SIZE + rows * FB_SIZE * (p[TYPE_INDEX] == 'i' ? 1 : 8) / 2;
+    }
+    }
+    return -1;
+}
+
+// Full frames only: the farm never negotiates deltas
+static int decode_frame(const uint8_t* p, uint8_t* rgb) {
+    const uint8_t* payload = p + PAYLOAD_OFFSET;
+    if (p[TYPE_INDEX] == '_') {
+        for (int i = 0; i < FB_SIZE * FB_SIZE; i++) memcpy(rgb + i * 3, payload + i * 4, 3);
+        return 1;
+    }
+    if (p[TYPE_INDEX] == 'I') {
+        const uint8_t* pixels = payload + PALETTE_SIZE;
+        for (int i = 0; i < FB_SIZE * FB_SIZE; i++) {
+            int index = (pixels[i >> 1] >> ((i & 1) * 4)) & 0x0F;
+            memcpy(rgb + i * 3, payload + index * 3, 3);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+static void write_ppm(const Job* job) {
+    char* path = NULL;
+    char* name = strdup(job->cart);
+    if (asprintf(&path, "%s/%s.ppm", out_dir, basename(name)) < 0) path = NULL;
+    FILE* f = path ? fopen(path, "wb") : NULL;
+    if (f) {
+        fprintf(f, "P6\n%d %d\n255\n", FB_SIZE, FB_SIZE);
+        fwrite(job->rgb, 1, sizeof(job->rgb), f);
+        fclose(f);
+    } else {
+        fprintf(stderr, "%s: %s\n", path ? path : job->cart, strerror(errno));
+    }
+    free(path);
+    free(name);
+}
+
+extern char** environ;
+
+// The child of a fork in this multithreaded process may only make async-signal-safe calls, so
+// everything the exec needs (log path, environment, argv) is built here first
+static pid_t spawn(const Job* job, const char* slot_dir, const char* prefix) {
+    static const char* const overridden[] = {"LD_PRELOAD=", "PICO_CHANNEL_PREFIX=", "PICO_HEADLESS="};
+    size_t count = 0;
+    while (environ[count]) count++;
+    char** envp = calloc(count + 4, sizeof(char*));
+    char *log_path = NULL, *preload = NULL, *channels = NULL;
+    // One log per cart, kept in the work dir for the ones that fail
+    if (!envp || asprintf(&log_path, "%s/%ld.log", work_dir, (long)(job - jobs)) < 0 ||
+        asprintf(&preload, "LD_PRELOAD=%s", shim_path) < 0 || asprintf(&channels, "PICO_CHANNEL_PREFIX=%s", prefix) < 0) {
+        free(envp);
+        return -1;
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        int keep = 1;
+        for (size_t k = 0; k < sizeof(overridden) / sizeof(overridden[0]); k++) {
+            if (strncmp(environ[i], overridden[k], strlen(overridden[k])) == 0) keep = 0;
+        }
+        if (keep) envp[n++] = environ[i];
+    }
+    envp[n++] = preload;
+    envp[n++] = channels;
+    envp[n++] = "PICO_HEADLESS=1";
+    char* const argv[] = {(char*)pico8_path, "-home", (char*)slot_dir, "-width", "128", "-height", "128",
+                          "-run", (char*)job->cart, NULL};
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        int log_fd = open(log_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (log_fd >= 0) {
+            dup2(log_fd, STDOUT_FILENO);
+            dup2(log_fd, STDERR_FILENO);
+            close(log_fd);
+        }
+        execve(pico8_path, argv, envp);
+        static const char failed[] = "picofarm: exec failed\n";
+        if (write(STDERR_FILENO, failed, sizeof(failed) - 1) < 0) {}
+        _exit(127);
+    }
+    free(log_path);
+    free(preload);
+    free(channels);
+    free(envp);
+    return pid;
+}
+
+static void stop(pid_t pid, Job* job) {
+    kill(pid, SIGTERM);
+    for (uint64_t deadline = now_ms() + STOP_GRACE_MS; now_ms() < deadline; usleep(10000)) {
+        if (waitpid(pid, &job->status, WNOHANG) == pid) return;
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, &job->status, 0);
+}
+
+static void run_job(Job* job, int slot) {
+    char *slot_dir = NULL, *prefix = NULL, *vid_path = NULL, *in_path = NULL;
+    if (asprintf(&slot_dir, "%s/%d", work_dir, slot) < 0 || asprintf(&prefix, "%s/pico8", slot_dir) < 0 ||
+        asprintf(&vid_path, "%s.vid", prefix) < 0 || asprintf(&in_path, "%s.in", prefix) < 0) {
+        perror("picofarm");
+        exit(1);
+    }
+    mkdir(slot_dir, 0755);
+    unlink(vid_path);
+    unlink(in_path);
+    if (mkfifo(vid_path, 0666) != 0 || mkfifo(in_path, 0666) != 0) {
+        perror(vid_path);
+        exit(1);
+    }
+
+    job->first_frame_ms = -1;
+    // Opening the read end without blocking: poll() only reports POLLHUP once a writer came and went
+    int vid_fd = open(vid_path, O_RDONLY | O_NONBLOCK);
+    uint64_t start = now_ms();
+    pid_t pid = spawn(job, slot_dir, prefix);
+    if (vid_fd < 0 || pid < 0) {
+        perror("picofarm");
+        exit(1);
+    }
+
+    uint8_t* buffer = malloc(READ_SIZE * 2);
+    size_t used = 0;
+    int in_fd = -1;
+    int hung_up = 0, reaped = 0;
+    uint64_t deadline = start + seconds * 1000ull;
+    while (!hung_up && now_ms() < deadline) {
+        // The shim opens its input end at SDL_Init; ask for indexed frames as soon as it's there
+        if (in_fd < 0 && (in_fd = open(in_path, O_WRONLY | O_NONBLOCK)) >= 0) {
+            uint8_t packet[IN_PACKET_SIZE] = {EVENT_VIDMODE, ENCODING_INDEXED, 0};
+            if (write(in_fd, packet, sizeof(packet)) != sizeof(packet)) perror(in_path);
+        }
+        struct pollfd pfd = {.fd = vid_fd, .events = POLLIN};
+        if (poll(&pfd, 1, 20) <= 0) {
+            // Catches instances that die before ever opening the video channel
+            reaped = waitpid(pid, &job->status, WNOHANG) == pid;
+            hung_up = reaped;
+            continue;
+        }
+        ssize_t n = read(vid_fd, buffer + used, READ_SIZE * 2 - used);
+        if (n <= 0) {
+            hung_up = n == 0 || errno != EAGAIN;
+            continue;
+        }
+        used += n;
+
+        size_t pos = 0;
+        while (used - pos >= PAYLOAD_OFFSET) {
+            uint8_t* p = buffer + pos;
+            if (memcmp(p, SYNC, SYNC_SIZE) != 0) {
+                pos++;
+                continue;
+            }
+            long size = packet_size(p, used - pos);
+            if (size < 0) {
+                pos++;
+                continue;
+            }
+            if (size == 0 || used - pos < (size_t)size) break;
+            if (decode_frame(p, job->rgb)) {
+                if (job->frames++ == 0) job->first_frame_ms = now_ms() - start;
+                atomic_fetch_add(&total_frames, 1);
+            }
+            memcpy(job->meta, p + META_INDEX, META_SIZE);
+            pos += size;
+        }
+        memmove(buffer, buffer + pos, used - pos);
+        used -= pos;
+    }
+    if (!reaped) reaped = waitpid(pid, &job->status, WNOHANG) == pid;
+    job->exited_early = hung_up || reaped;
+    if (!reaped) stop(pid, job);
+
+    free(buffer);
+    if (in_fd >= 0) close(in_fd);
+    close(vid_fd);
+    unlink(vid_path);
+    unlink(in_path);
+    free(slot_dir);
+    free(prefix);
+    free(vid_path);
+    free(in_path);
+}
+
+static int remove_entry(const char* path, const struct stat* st, int type, struct FTW* ftw) {
+    (void)st;
+    (void)type;
+    (void)ftw;
+    remove(path);
+    return 0;
+}
+
+static void* slot_worker(void* arg) {
+    int slot = (int)(intptr_t)arg;
+    for (;;) {
+        int i = atomic_fetch_add(&next_job, 1);
+        if (i >= job_count) break;
+        Job* job = &jobs[i];
+        run_job(job, slot);
+        if (out_dir && job->frames) write_ppm(job);
+        char end[48];
+        if (!job->exited_early) snprintf(end, sizeof(end), "ran %d s", seconds);
+        else if (WIFSIGNALED(job->status)) snprintf(end, sizeof(end), "DIED (signal %d)", WTERMSIG(job->status));
+        else snprintf(end, sizeof(end), "EXITED (status %d)", WEXITSTATUS(job->status));
+        printf("%s: %lu frames, first frame %.0f ms, state %d/%d/%d, %s\n", job->cart, job->frames,
+               job->first_frame_ms, job->meta[0], job->meta[1], job->meta[2] * 2, end);
+        fflush(stdout);
+        if (!job->exited_early && job->frames) {
+            char* log_path = NULL;
+            if (asprintf(&log_path, "%s/%d.log", work_dir, i) >= 0) unlink(log_path);
+            free(log_path);
+        }
+    }
+    return NULL;
+}
+
+static void usage() {
+    fprintf(stderr, "Usage: picofarm [-j slots] [-t seconds] [-o outdir] [-s picoshim.so] [-p pico8_64] <cart>...\n");
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    int slots = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (slots < 1) slots = 1;
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        const char* opt = argv[arg];
+        if (arg + 1 >= argc) usage();
+        if (strcmp(opt, "-j") == 0) {
+            slots = atoi(argv[++arg]);
+            if (slots < 1) slots = 1;
+        } else if (strcmp(opt, "-t") == 0) {
+            seconds = atoi(argv[++arg]);
+            if (seconds < 1) seconds = 1;
+        } else if (strcmp(opt, "-o") == 0) {
+            out_dir = argv[++arg];
+        } else if (strcmp(opt, "-s") == 0) {
+            shim_path = argv[++arg];
+        } else if (strcmp(opt, "-p") == 0) {
+            pico8_path = argv[++arg];
+        } else {
+            usage();
+        }
+    }
+    if (arg >= argc) usage();
+
+    // The instances' cwd is ours, but LD_PRELOAD and -run need paths that survive it
+    char* shim_abs = realpath(shim_path, NULL);
+    if (!shim_abs) {
+        perror(shim_path);
+        return 1;
+    }
+    shim_path = shim_abs;
+    job_count = argc - arg;
+    jobs = calloc(job_count, sizeof(Job));
+    for (int i = 0; i < job_count; i++) {
+        char* cart = realpath(argv[arg + i], NULL);
+        jobs[i].cart = cart ? cart : argv[arg + i];
+    }
+    if (slots > job_count) slots = job_count;
+    if (out_dir) mkdir(out_dir, 0755);
+    if (!mkdtemp(work_dir)) {
+        perror(work_dir);
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    uint64_t start = now_ms();
+    pthread_t* tids = calloc(slots, sizeof(pthread_t));
+    int started = 0;
+    for (; started < slots; started++) {
+        if (pthread_create(&tids[started], NULL, slot_worker, (void*)(intptr_t)started) != 0) break;
+    }
+    if (started == 0) slot_worker(NULL);
+    for (int i = 0; i < started; i++) pthread_join(tids[i], NULL);
+    double elapsed = (now_ms() - start) / 1000.0;
+
+    int failed = 0;
+    for (int i = 0; i < job_count; i++) failed += jobs[i].exited_early || jobs[i].frames == 0;
+    printf("picofarm: %d carts, %d failed, %lu frames in %.1f s (%.0f frames/s, %d slots)\n", job_count, failed,
+           atomic_load(&total_frames), elapsed, atomic_load(&total_frames) / elapsed, started ? started : 1);
+    if (failed) {
+        printf("picofarm: logs of the failed carts are in %s\n", work_dir);
+    } else {
+        nftw(work_dir, remove_entry, 32, FTW_DEPTH | FTW_PHYS);
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,96 @@
+// Pixel conversion kernels: SDL XRGB8888 surface -> Godot RGBA8 (little endian 0xAABBGGRR).
+// Shared by shim.c and pixconv_bench.c. Every vector path must match the scalar one bit for bit.
+#ifndef PIXCONV_H
+#define PIXCONV_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+static inline void pixconv_scalar(const uint32_t* src, uint32_t* dst, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        uint32_t pixel = src[i];
+        // RGB to ABGR (or whatever Godot needs, this was working before)
+        dst[i] = ((pixel & 0x00FF0000) >> 16) |
+                  (pixel & 0x0000FF00)         |
+                 ((pixel & 0x000000FF) << 16) |
+                  0xFF000000;
+    }
+}
+
+#if defined(__aarch64__)
+// 16 pixels per step: de-interleave B,G,R,X planes and re-interleave as R,G,B,0xFF
+static inline void pixconv_neon(const uint32_t* src, uint32_t* dst, size_t count) {
+    size_t i = 0;
+    const uint8x16_t alpha = vdupq_n_u8(0xFF);
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x4_t bgrx = vld4q_u8((const uint8_t*)(src + i));
+        uint8x16x4_t rgba;
+        rgba.val[0] = bgrx.val[2];
+        rgba.val[1] = bgrx.val[1];
+        rgba.val[2] = bgrx.val[0];
+        rgba.val[3] = alpha;
+        vst4q_u8((uint8_t*)(dst + i), rgba);
+    }
+    pixconv_scalar(src + i, dst + i, count - i);
+}
+#endif
+
+#if defined(__x86_64__)
+// SSE2 has no byte shuffle, so swap R/B with shifts and masks (4 pixels per step)
+static inline void pixconv_sse2(const uint32_t* src, uint32_t* dst, size_t count) {
+    size_t i = 0;
+    const __m128i mask_g = _mm_set1_epi32(0x0000FF00);
+    const __m128i mask_b = _mm_set1_epi32(0x000000FF);
+    const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+    for (; i + 4 <= count; i += 4) {
+        __m128i p = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i r = _mm_and_si128(_mm_srli_epi32(p, 16), mask_b);
+        __m128i g = _mm_and_si128(p, mask_g);
+        __m128i b = _mm_slli_epi32(_mm_and_si128(p, mask_b), 16);
+        __m128i out = _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, alpha));
+        _mm_storeu_si128((__m128i*)(dst + i), out);
+    }
+    pixconv_scalar(src + i, dst + i, count - i);
+}
+
+// AVX2: one byte shuffle per 8 pixels, alpha forced with an OR
+__attribute__((target("avx2")))
+static inline void pixconv_avx2(const uint32_t* src, uint32_t* dst, size_t count) {
+    size_t i = 0;
+    const __m256i shuffle = _mm256_setr_epi8(
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    const __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+    for (; i + 8 <= count; i += 8) {
+        __m256i p = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i out = _mm256_or_si256(_mm256_shuffle_epi8(p, shuffle), alpha);
+        _mm256_storeu_si256((__m256i*)(dst + i), out);
+    }
+    pixconv_scalar(src + i, dst + i, count - i);
+}
+#endif
+
+typedef void (*pixconv_fn)(const uint32_t* src, uint32_t* dst, size_t count);
+
+// Best kernel for this CPU: NEON on aarch64, AVX2 when the CPU has it, else SSE2, else scalar
+static inline pixconv_fn pixconv_select(void) {
+#if defined(__aarch64__)
+    return pixconv_neon;
+#elif defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return pixconv_avx2;
+    }
+    return pixconv_sse2;
+#else
+    return pixconv_scalar;
+#endif
+}
+
+#endif
@@ -0,0 +1,86 @@
+// Micro-benchmark for the pixel conversion kernels in pixconv.h.
+// Build: gcc -O3 -o pixconv_bench pixconv_bench.c
+// Usage: ./pixconv_bench [frames]
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pixconv.h"
+
+#define FB_PIXELS (128 * 128)
+#define DEFAULT_FRAMES 20000
+
+typedef struct {
+    const char* name;
+    pixconv_fn fn;
+} Variant;
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+int main(int argc, char** argv) {
+    int frames = (argc > 1) ? atoi(argv[1]) : DEFAULT_FRAMES;
+    if (frames <= 0) frames = DEFAULT_FRAMES;
+
+    static uint32_t src[FB_PIXELS];
+    static uint32_t expected[FB_PIXELS];
+    static uint32_t dst[FB_PIXELS];
+
+    // Pseudo-random XRGB frame, including junk in the X byte
+    uint32_t seed = 0x12345678;
+    for (int i = 0; i < FB_PIXELS; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        src[i] = seed;
+    }
+    pixconv_scalar(src, expected, FB_PIXELS);
+
+    Variant variants[4];
+    int count = 0;
+    variants[count++] = (Variant){"scalar", pixconv_scalar};
+#if defined(__aarch64__)
+    variants[count++] = (Variant){"neon", pixconv_neon};
+#elif defined(__x86_64__)
+    variants[count++] = (Variant){"sse2", pixconv_sse2};
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        variants[count++] = (Variant){"avx2", pixconv_avx2};
+    }
+#endif
+
+    printf("pixconv_bench: %d frames of 128x128 XRGB8888 -> RGBA8\n", frames);
+    int failures = 0;
+    for (int v = 0; v < count; v++) {
+        // Bit-exact check against scalar, including odd tails
+        memset(dst, 0, sizeof(dst));
+        variants[v].fn(src, dst, FB_PIXELS);
+        int ok = memcmp(dst, expected, sizeof(dst)) == 0;
+        memset(dst, 0, sizeof(dst));
+        variants[v].fn(src + 1, dst, FB_PIXELS - 3);
+        ok = ok && memcmp(dst, expected + 1, (FB_PIXELS - 3) * sizeof(uint32_t)) == 0 && dst[FB_PIXELS - 3] == 0;
+        if (!ok) failures++;
+
+        uint64_t start = now_ns();
+        for (int f = 0; f < frames; f++) {
+            variants[v].fn(src, dst, FB_PIXELS);
+            // Keep the compiler from eliding repeated conversions
+            __asm__ __volatile__("" : : "r"(dst) : "memory");
+        }
+        uint64_t elapsed = now_ns() - start;
+        double ns_per_frame = (double)elapsed / frames;
+        double mb_per_s = (double)FB_PIXELS * 4 * frames / ((double)elapsed / 1e9) / (1024.0 * 1024.0);
+        printf("  %-8s %10.1f ns/frame %10.1f MB/s  %s\n",
+               variants[v].name, ns_per_frame, mb_per_s, ok ? "bit-exact" : "MISMATCH");
+    }
+    pixconv_fn selected = pixconv_select();
+    for (int v = 0; v < count; v++) {
+        if (variants[v].fn == selected) {
+            printf("selected by shim: %s\n", variants[v].name);
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -11,8 +11,19 @@
 #include <stdbool.h>
 #include <sys/stat.h>
 #include <errno.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <signal.h>
+#include <limits.h> // PIPE_BUF
+#include <time.h>
 #include <SDL2/SDL.h>
 #include <link.h> // For dl_iterate_phdr
+#include <sys/wait.h>
+#include <poll.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "pixconv.h"
+#include "capture.h"
 
 #define FINDSDL(VAR, NAME) \
     if (!(VAR)) { \
@@ -26,8 +37,22 @@
 static int vid_fd = -1;
 static int in_fd = -1;
 
-#define FIFO_VID_PATH "/tmp/pico8.vid"
-#define FIFO_IN_PATH "/tmp/pico8.in"
+// Channel paths are PICO_CHANNEL_PREFIX + suffix, so several instances can run side by side
+// (e.g. PICO_CHANNEL_PREFIX=/tmp/farm/3/pico8). Resolved by shim_channels_init at load.
+#define CHANNEL_PREFIX_DEFAULT "/tmp/pico8"
+static char fifo_vid_path[PATH_MAX];
+static char fifo_in_path[PATH_MAX];
+static char fifo_fb_path[PATH_MAX]; // Shared-memory frame ring (regular file, mmap'd)
+static char fifo_aud_path[PATH_MAX]; // Direct PCM channel (PICO_AUDIO_DIRECT=1)
+
+static void shim_channels_init() {
+    const char* prefix = getenv("PICO_CHANNEL_PREFIX");
+    if (!prefix || !*prefix) prefix = CHANNEL_PREFIX_DEFAULT;
+    snprintf(fifo_vid_path, sizeof(fifo_vid_path), "%s.vid", prefix);
+    snprintf(fifo_in_path, sizeof(fifo_in_path), "%s.in", prefix);
+    snprintf(fifo_fb_path, sizeof(fifo_fb_path), "%s.fb", prefix);
+    snprintf(fifo_aud_path, sizeof(fifo_aud_path), "%s.aud", prefix);
+}
 
 static Uint8 keystate[256];
 
@@ -35,8 +60,24 @@ static uint8_t* picoram = NULL;
 static size_t picoram_size = 0;
 
 // Version Guarding
-#define PICO8_VERSION_0_2_7_SIZE 1640888
-static bool is_version_0_2_7 = false;
+// Builds whose memory layout is known, recognised by executable size (cheap, no hashing). ram_size is the
+// allocation PICO-8 zeroes at startup, the block picoram points to; app_struct and cconfig are offsets of
+// static structs from base_addr. The PICORAM_INDEX_* offsets below are 0.2.7's.
+typedef struct {
+    const char* version;
+    off_t exe_size;
+    size_t ram_size;
+    uintptr_t app_struct;
+    uintptr_t cconfig;
+} Pico8Build;
+
+static const Pico8Build pico8_builds[] = {
+    {"0.2.7", 1640888, 0x37000, 0x1a0e60, 0x3d86c0},
+};
+#define PICO8_BUILD_COUNT (sizeof(pico8_builds) / sizeof(pico8_builds[0]))
+#define PICO8_RAM_SIZE_DEFAULT 0x37000 // Used by PICO_RAM_PROBE=1 on unknown builds
+
+static const Pico8Build* pico8_build = NULL; // NULL: Safe Mode
 
 // #define MAX_CANDIDATES 16
 // typedef struct {
@@ -65,17 +106,125 @@ static bool is_version_0_2_7 = false;
 #define PIDOT_EVENT_MOUSEEV 1
 #define PIDOT_EVENT_KEYEV 2
 #define PIDOT_EVENT_CHAREV 3
+#define PIDOT_EVENT_VIDMODE 4 // Frontend negotiates the video packet encoding: Mode(1) + Flags(1)
+#define PIDOT_EVENT_SNAPSHOT 5 // Op(1) + Slot(1), carried out at the next frame boundary (see snap_frame_boundary)
+#define PIDOT_EVENT_CONTROL 6 // Op(1) + Arg(1) + Token(1), see ctl_receive
+
+// Control ops, applied as soon as the packet is read (never queued behind input or recorded)
+#define CTL_OP_PAUSE 0 // Block at the next frame boundary until RESUME, no CPU while waiting
+#define CTL_OP_RESUME 1
+#define CTL_OP_FPS_CAP 2 // Arg: presents per second, 0 = uncapped
+#define CTL_OP_VIDEO 3 // Arg 0: the game keeps running but no frames are published, 1: publish again
+#define CTL_FLAG_PAUSED 0x01
+#define CTL_FLAG_VIDEO_OFF 0x02
+static bool ctl_paused = false; // Game thread only, like the two below
+static uint8_t ctl_fps_cap = 0;
+static bool ctl_video_off = false;
+static void ctl_receive(const uint8_t* packet); // After the video and audio channels it acts on
 
-#define IN_PACKET_SIZE 8 // Event(1) + X(2) + Y(2) + Mask(1) + Pad(2)
+#define IN_PACKET_SIZE 16 // Event(1) + X(2) + Y(2) + Mask(1) + Pad(2) + Seq(4) + Timestamp(4)
+#define IN_SEQ_OFFSET 8
+#define IN_TIMESTAMP_OFFSET 12 // Frontend wall clock, microseconds mod 2^32 (0 = unknown)
 static uint8_t in_packet[IN_PACKET_SIZE];
+
+// Everything available on the input FIFO is read in one syscall and queued here
+#define IN_RING_PACKETS 256
+#define IN_READ_BUFFER_SIZE (IN_PACKET_SIZE * 64)
+#define IN_STATS_INTERVAL 500
+static uint8_t in_ring[IN_RING_PACKETS][IN_PACKET_SIZE];
+static int in_ring_head = 0;
+static int in_ring_count = 0;
+static uint8_t in_read_buffer[IN_READ_BUFFER_SIZE];
+static size_t in_read_carry = 0; // Bytes of a partial packet kept from the last read
+
+// Input latency / batching counters
+static uint32_t in_last_seq = 0;
+static unsigned long in_events_consumed = 0;
+static unsigned long in_events_coalesced = 0;
+static unsigned long in_seq_skipped = 0; // Sequence numbers never consumed (coalesced + dropped + lost)
+static unsigned long in_ring_dropped = 0;
+static uint64_t in_latency_total_us = 0;
+static uint32_t in_latency_max_us = 0;
+static unsigned long in_latency_samples = 0;
+
+static uint32_t vid_present_seq = 0; // Presents so far (game thread), also the input record/replay clock
 #define FB_WIDTH 128
 #define FB_HEIGHT 128
 #define PIXEL_SIZE (FB_WIDTH * FB_HEIGHT * 4)
-#define HEADER_SIZE 11 // "PICO8SYNC__"
+#define HEADER_SIZE 11 // "PICO8SYNC" + PacketType(1) + Reserved(1)
 #define META_SIZE 3 // NavState + MasterState + Volume
-#define PACKET_SIZE (HEADER_SIZE + META_SIZE + PIXEL_SIZE) 
+#define FRAME_INFO_SIZE 8 // FrameSeq(4) + CaptureTimestamp(4, wall clock microseconds mod 2^32)
+#define PAYLOAD_OFFSET (HEADER_SIZE + META_SIZE + FRAME_INFO_SIZE)
+#define PACKET_SIZE (PAYLOAD_OFFSET + PIXEL_SIZE)
+
+// Every packet starts with the same PAYLOAD_OFFSET byte header: "PICO8SYNC"(9) + PacketType(1) + Reserved(1, '_')
+// + NavState + MasterState + Volume + FrameSeq(4) + CaptureTimestamp(4). The type-specific payload follows;
+// '_' is a full RGBA frame, as in the original "PICO8SYNC__" packet (which had no FrameSeq/CaptureTimestamp).
+#define VID_TYPE_INDEX 9
+#define VID_PKT_RGBA '_'
+#define VID_PKT_INDEXED 'I'
+#define VID_PKT_KEEPALIVE 'K' // Frame unchanged, metadata only
+#define VID_PKT_RGBA_DELTA 'd' // RowMask(16) + changed RGBA rows
+#define VID_PKT_INDEXED_DELTA 'i' // Palette(48) + RowMask(16) + changed 4bpp rows
+#define VID_PKT_SHM_FRAME 'S' // Slot(1) + Pad(3) + Seq(4): frame published in the shared ring
+#define VID_PKT_TELEMETRY 'T' // Shim pipeline counters, see vid_send_telemetry
+#define VID_PKT_READY 'R' // Boot phase timestamps, sent once per reader after its first frame
+#define VID_PKT_CONTROL 'C' // Control ack: Token(1) + Flags(1) + FpsCap(1) + Pad(1) + PresentSeq(4), see vid_send_control
+
+// Encodings the frontend can request with PIDOT_EVENT_VIDMODE
+#define VID_ENCODING_RGBA 0
+#define VID_ENCODING_INDEXED 1
+
+// Indexed payload: 16-entry RGB palette + 4bpp pixels (low nibble = left pixel)
+#define PALETTE_COLORS 16
+#define PALETTE_SIZE (PALETTE_COLORS * 3)
+#define INDEXED_PIXEL_SIZE (FB_WIDTH * FB_HEIGHT / 2)
+#define INDEXED_PACKET_SIZE (PAYLOAD_OFFSET + PALETTE_SIZE + INDEXED_PIXEL_SIZE)
 
-#define FIFO_NAME_VID "/tmp/pico8.vid" 
+// VIDMODE flags
+#define VID_FLAG_DELTA 0x01 // Frontend accepts keepalive + dirty-row delta packets
+#define VID_FLAG_SHM 0x02 // Frames go through fifo_fb_path, the FIFO only carries doorbells
+
+// Delta payloads: one bit per scanline (bit y&7 of byte y>>3), then only the set rows
+#define ROW_MASK_SIZE (FB_HEIGHT / 8)
+#define RGBA_ROW_SIZE (FB_WIDTH * 4)
+#define INDEXED_ROW_SIZE (FB_WIDTH / 2)
+// Send a keepalive at least this often while the screen is static
+#define VID_KEEPALIVE_FRAMES 30
+
+// Shared-memory ring layout (little endian):
+// File header: "PICO8FB1"(8) + SlotCount(4) + SlotSize(4), padded to 64 bytes
+// Each slot: Seq(4, odd while writing) + PacketType(4) + Length(4) + Pad(4) + payload
+#define SHM_SLOTS 3
+#define SHM_HEADER_SIZE 64
+#define SHM_SLOT_HEADER_SIZE 16
+#define SHM_SLOT_SIZE (SHM_SLOT_HEADER_SIZE + PIXEL_SIZE)
+#define SHM_FILE_SIZE (SHM_HEADER_SIZE + SHM_SLOTS * SHM_SLOT_SIZE)
+#define SHM_DOORBELL_SIZE 8
+
+typedef struct {
+    uint32_t seq;
+    uint32_t type;
+    uint32_t length;
+    uint32_t pad;
+    uint8_t data[PIXEL_SIZE];
+} ShmSlot;
+
+static uint8_t* shm_base = NULL;
+static int shm_next_slot = 0;
+
+// Active mode (sender thread) and the mode requested via VIDMODE (game thread, under vid_mutex)
+static uint8_t vid_encoding = VID_ENCODING_RGBA;
+static uint8_t vid_flags = 0;
+static uint8_t vid_req_encoding = VID_ENCODING_RGBA;
+static uint8_t vid_req_flags = 0;
+static bool vid_req_reset = false;
+
+// Last frame the reader actually received (source XRGB), for delta/skip decisions
+static uint32_t last_sent_frame[FB_WIDTH * FB_HEIGHT];
+static bool last_frame_valid = false;
+static uint8_t last_sent_meta[META_SIZE];
+static int frames_since_packet = 0;
 
 // Helper to ensure all bytes are written to a potentially blocking FD
 static ssize_t write_all(int fd, const void* buf, size_t len) {
@@ -121,30 +270,58 @@ static uintptr_t get_base_address() {
 //simple check for file size for speed reasons
 static void check_pico8_version() {
     struct stat st;
-    if (stat("/proc/self/exe", &st) == 0) {
-        if (st.st_size == PICO8_VERSION_0_2_7_SIZE) {
-            is_version_0_2_7 = true;
-            printf("SHIM: PICO-8 Version 0.2.7 DETECTED (Size: %ld bytes). Advanced features enabled.\n", st.st_size);
-        } else {
-            is_version_0_2_7 = false;
-            printf("SHIM: PICO-8 Version Mismatch (Size: %ld bytes). Expected %d for 0.2.7.\n", st.st_size, PICO8_VERSION_0_2_7_SIZE);
-            printf("SHIM: Safe Mode Enabled (Input/Video only, no Auto-Pause/Keyboard/Splore detection).\n");
-        }
-    } else {
+    if (stat("/proc/self/exe", &st) != 0) {
         perror("SHIM: Failed to stat /proc/self/exe");
+        return;
     }
+    for (size_t i = 0; i < PICO8_BUILD_COUNT; i++) {
+        if (st.st_size == pico8_builds[i].exe_size) {
+            pico8_build = &pico8_builds[i];
+            printf("SHIM: PICO-8 Version %s DETECTED (Size: %ld bytes). Advanced features enabled.\n", pico8_build->version, st.st_size);
+            return;
+        }
+    }
+    printf("SHIM: PICO-8 Version Mismatch (Size: %ld bytes). Known builds:", st.st_size);
+    for (size_t i = 0; i < PICO8_BUILD_COUNT; i++) printf(" %s (%ld)", pico8_builds[i].version, (long)pico8_builds[i].exe_size);
+    printf("\nSHIM: Safe Mode Enabled (Input/Video only, no Auto-Pause/Keyboard/Splore detection).\n");
 }
 
 static uintptr_t base_addr = 0;
 
+// Map the shared frame ring. Created the first time the frontend negotiates VID_FLAG_SHM, so instances
+// that never ask for it (picofarm, FIFO-only frontends) don't get a 192 KB file. Game thread.
+static void shim_shm_init() {
+    int fd = open(fifo_fb_path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        perror("SHIM: Failed to create frame ring");
+        return;
+    }
+    fchmod(fd, 0666);
+    if (ftruncate(fd, SHM_FILE_SIZE) != 0) {
+        perror("SHIM: Failed to size frame ring");
+        close(fd);
+        return;
+    }
+    void* map = mmap(NULL, SHM_FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("SHIM: Failed to map frame ring");
+        return;
+    }
+    shm_base = map;
+    uint32_t slots = SHM_SLOTS;
+    uint32_t slot_size = SHM_SLOT_SIZE;
+    memcpy(shm_base, "PICO8FB1", 8);
+    memcpy(shm_base + 8, &slots, 4);
+    memcpy(shm_base + 12, &slot_size, 4);
+    printf("SHIM: Frame ring mapped at %s (%d slots)\n", fifo_fb_path, SHM_SLOTS);
+}
+
 void shim_fifo_init() {
-    printf("SHIM: Using Host-Created FIFOs at %s and %s\n", FIFO_IN_PATH, FIFO_VID_PATH);
-    
-    // Check version immediately
-    check_pico8_version();
+    printf("SHIM: Using Host-Created FIFOs at %s and %s\n", fifo_in_path, fifo_vid_path);
     
     // Eagerly open Input FIFO so Godot (Writer) has a target
-    in_fd = open(FIFO_IN_PATH, O_RDONLY | O_NONBLOCK);
+    in_fd = open(fifo_in_path, O_RDONLY | O_NONBLOCK);
     if (in_fd < 0) {
         perror("SHIM: Failed to open Input FIFO eagerly");
     } else {
@@ -159,20 +336,215 @@ void shim_fifo_init() {
 
 
 
-// Try to read a packet from the client
-// Returns true if a full packet was read
-static bool pico_poll_event() {
+static uint32_t wallclock_us32() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000ull + ts.tv_nsec / 1000);
+}
+
+static uint64_t monotonic_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+// Boot phases, wall clock usec mod 2^32 (same clock as CaptureTimestamp). 0 = not reached yet.
+// They go to the frontend in the 'R' packet so time-to-first-frame can be lined up with its own marks.
+enum { BOOT_SHIM_LOAD, BOOT_SDL_INIT, BOOT_INPUT_FIFO, BOOT_VIDEO_FIFO, BOOT_FIRST_FRAME, BOOT_PHASES };
+static uint32_t boot_us[BOOT_PHASES];
+
+static void boot_mark(int phase) {
+    if (!boot_us[phase]) boot_us[phase] = wallclock_us32();
+}
+
+// RAM discovery. PICO-8 zeroes its RAM block with a single memset of ram_size at startup. Rather than
+// exporting memset for the whole process, the GOT slots every loaded object (other than the shim) uses
+// for memset are pointed at ram_probe() from the constructor, and put back to libc's memset as soon as
+// that call is seen: from then on memset costs exactly what it does without the shim.
+typedef void* (*MemsetFn)(void*, int, size_t);
+#define RAM_PROBE_MAX_SLOTS 16
+#if __LP64__
+#define RAM_PROBE_R_SYM ELF64_R_SYM
+#else
+#define RAM_PROBE_R_SYM ELF32_R_SYM
+#endif
+
+typedef struct {
+    MemsetFn* slot;
+    bool relro; // Read-only after relocation, needs an mprotect around the write
+} RamProbeSlot;
+
+static MemsetFn real_memset = NULL;
+static RamProbeSlot ram_probe_slots[RAM_PROBE_MAX_SLOTS];
+static int ram_probe_slot_count = 0;
+static size_t ram_probe_size = 0;
+static bool ram_probe_armed = false;
+
+static bool ram_probe_write(const RamProbeSlot* s, MemsetFn fn) {
+    uintptr_t page_size = (uintptr_t)sysconf(_SC_PAGESIZE);
+    void* page = (void*)((uintptr_t)s->slot & ~(page_size - 1));
+    if (s->relro && mprotect(page, page_size, PROT_READ | PROT_WRITE) != 0) return false;
+    __atomic_store_n(s->slot, fn, __ATOMIC_RELEASE);
+    if (s->relro) mprotect(page, page_size, PROT_READ);
+    return true;
+}
+
+static void ram_probe_disarm() {
+    for (int i = 0; i < ram_probe_slot_count; i++) {
+        ram_probe_write(&ram_probe_slots[i], real_memset);
+    }
+    printf("SHIM: RAM probe removed (%d GOT slots restored)\n", ram_probe_slot_count);
+}
+
+static void* ram_probe(void* s, int c, size_t n) {
+    if (c == 0 && n == ram_probe_size && __atomic_exchange_n(&ram_probe_armed, false, __ATOMIC_ACQ_REL)) {
+        picoram = s;
+        picoram_size = n;
+        printf("SHIM: PICO-8 RAM Locked: %p (Size %zx)\n", picoram, picoram_size);
+        ram_probe_disarm();
+    }
+    return real_memset(s, c, n);
+}
+
+// d_ptr values are link-time addresses unless the loader already relocated them in place
+static uintptr_t dyn_ptr(uintptr_t base, ElfW(Addr) ptr) {
+    return ptr < base ? base + ptr : ptr;
+}
+
+static void ram_probe_scan_relocs(uintptr_t base, uintptr_t table, size_t table_size, size_t entry_size,
+                                  const ElfW(Sym)* symtab, const char* strtab, uintptr_t relro_start, uintptr_t relro_end) {
+    for (size_t off = 0; off + entry_size <= table_size; off += entry_size) {
+        const ElfW(Rel)* rel = (const ElfW(Rel)*)(table + off);
+        size_t sym = RAM_PROBE_R_SYM(rel->r_info);
+        if (sym == 0 || strcmp(strtab + symtab[sym].st_name, "memset") != 0) continue;
+        if (entry_size == sizeof(ElfW(Rela)) && ((const ElfW(Rela)*)rel)->r_addend != 0) continue;
+        if (ram_probe_slot_count == RAM_PROBE_MAX_SLOTS) return;
+        uintptr_t slot = base + rel->r_offset;
+        ram_probe_slots[ram_probe_slot_count++] = (RamProbeSlot){(MemsetFn*)slot, slot >= relro_start && slot < relro_end};
+    }
+}
+
+static int ram_probe_phdr_handler(struct dl_phdr_info* info, size_t size, void* data) {
+    (void)size;
+    uintptr_t self = (uintptr_t)data;
+    uintptr_t base = info->dlpi_addr;
+    const ElfW(Dyn)* dyn = NULL;
+    uintptr_t relro_start = 0, relro_end = 0;
+    uintptr_t page_size = (uintptr_t)sysconf(_SC_PAGESIZE);
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr)* ph = &info->dlpi_phdr[i];
+        uintptr_t start = base + ph->p_vaddr;
+        if (ph->p_type == PT_LOAD && self >= start && self < start + ph->p_memsz) return 0; // The shim itself
+        if (ph->p_type == PT_DYNAMIC) dyn = (const ElfW(Dyn)*)start;
+        if (ph->p_type == PT_GNU_RELRO) {
+            // The loader only protects whole pages, the last partial page stays writable
+            relro_start = start & ~(page_size - 1);
+            relro_end = (start + ph->p_memsz) & ~(page_size - 1);
+        }
+    }
+    if (!dyn) return 0;
+
+    const ElfW(Sym)* symtab = NULL;
+    const char* strtab = NULL;
+    uintptr_t jmprel = 0, rel = 0, rela = 0;
+    size_t jmprel_size = 0, rel_size = 0, rela_size = 0;
+    bool jmprel_is_rela = false;
+    for (; dyn->d_tag != DT_NULL; dyn++) {
+        switch (dyn->d_tag) {
+        case DT_SYMTAB: symtab = (const ElfW(Sym)*)dyn_ptr(base, dyn->d_un.d_ptr); break;
+        case DT_STRTAB: strtab = (const char*)dyn_ptr(base, dyn->d_un.d_ptr); break;
+        case DT_JMPREL: jmprel = dyn_ptr(base, dyn->d_un.d_ptr); break;
+        case DT_PLTRELSZ: jmprel_size = dyn->d_un.d_val; break;
+        case DT_PLTREL: jmprel_is_rela = dyn->d_un.d_val == DT_RELA; break;
+        case DT_REL: rel = dyn_ptr(base, dyn->d_un.d_ptr); break;
+        case DT_RELSZ: rel_size = dyn->d_un.d_val; break;
+        case DT_RELA: rela = dyn_ptr(base, dyn->d_un.d_ptr); break;
+        case DT_RELASZ: rela_size = dyn->d_un.d_val; break;
+        }
+    }
+    if (!symtab || !strtab) return 0;
+    // PLT calls go through DT_JMPREL, address-taken or -fno-plt calls through GLOB_DAT in DT_REL(A)
+    if (jmprel) {
+        ram_probe_scan_relocs(base, jmprel, jmprel_size, jmprel_is_rela ? sizeof(ElfW(Rela)) : sizeof(ElfW(Rel)),
+                              symtab, strtab, relro_start, relro_end);
+    }
+    if (rela) ram_probe_scan_relocs(base, rela, rela_size, sizeof(ElfW(Rela)), symtab, strtab, relro_start, relro_end);
+    if (rel) ram_probe_scan_relocs(base, rel, rel_size, sizeof(ElfW(Rel)), symtab, strtab, relro_start, relro_end);
+    return 0;
+}
+
+// Known builds always; PICO_RAM_PROBE=1 also arms it on unknown ones (to check a new release still
+// allocates its RAM the same way), nothing reads picoram there though.
+static void ram_probe_install() {
+    const char* force = getenv("PICO_RAM_PROBE");
+    if (!pico8_build && !(force && strcmp(force, "1") == 0)) return;
+    FINDSDL(real_memset, memset);
+    ram_probe_size = pico8_build ? pico8_build->ram_size : PICO8_RAM_SIZE_DEFAULT;
+    dl_iterate_phdr(ram_probe_phdr_handler, (void*)(uintptr_t)ram_probe_install);
+    if (ram_probe_slot_count == 0) {
+        printf("SHIM: RAM probe found no memset GOT slots, advanced features unavailable\n");
+        return;
+    }
+    ram_probe_armed = true;
+    int armed = 0;
+    for (int i = 0; i < ram_probe_slot_count; i++) {
+        armed += ram_probe_write(&ram_probe_slots[i], ram_probe);
+    }
+    printf("SHIM: RAM probe armed on %d/%d memset GOT slots (size %zx)\n", armed, ram_probe_slot_count, ram_probe_size);
+}
+
+__attribute__((constructor)) static void shim_load() {
+    boot_mark(BOOT_SHIM_LOAD);
+    shim_channels_init();
+    check_pico8_version();
+    ram_probe_install();
+}
+
+// Queue one packet. Consecutive mouse moves with the same button mask collapse to the latest position.
+static void in_ring_push(const uint8_t* packet) {
+    if (in_ring_count > 0 && packet[0] == PIDOT_EVENT_MOUSEEV) {
+        uint8_t* tail = in_ring[(in_ring_head + in_ring_count - 1) % IN_RING_PACKETS];
+        if (tail[0] == PIDOT_EVENT_MOUSEEV && tail[3] == packet[3]) {
+            memcpy(tail, packet, IN_PACKET_SIZE);
+            in_events_coalesced++;
+            return;
+        }
+    }
+    if (in_ring_count == IN_RING_PACKETS) {
+        // Full: drop the oldest, newest state matters most
+        in_ring_head = (in_ring_head + 1) % IN_RING_PACKETS;
+        in_ring_count--;
+        in_ring_dropped++;
+    }
+    memcpy(in_ring[(in_ring_head + in_ring_count) % IN_RING_PACKETS], packet, IN_PACKET_SIZE);
+    in_ring_count++;
+}
+
+// Drain everything the frontend has written so far with a single read()
+static void in_fill_ring() {
     // Check if open (eagerly opened in init, but maybe failed/closed)
     if (in_fd < 0) {
         // Try to reopen
-        in_fd = open(FIFO_IN_PATH, O_RDONLY | O_NONBLOCK);
-        if (in_fd < 0) return false;
+        in_fd = open(fifo_in_path, O_RDONLY | O_NONBLOCK);
+        if (in_fd < 0) return;
+        in_read_carry = 0;
         printf("SHIM: Connected to Input FIFO (Lazy/Retry)\n");
+        boot_mark(BOOT_INPUT_FIFO);
     }
 
-    ssize_t n = read(in_fd, in_packet, IN_PACKET_SIZE);
-    if (n == IN_PACKET_SIZE) {
-        return true;
+    ssize_t n = read(in_fd, in_read_buffer + in_read_carry, IN_READ_BUFFER_SIZE - in_read_carry);
+    if (n > 0) {
+        size_t available = in_read_carry + n;
+        size_t pos = 0;
+        for (; pos + IN_PACKET_SIZE <= available; pos += IN_PACKET_SIZE) {
+            if (in_read_buffer[pos] == PIDOT_EVENT_CONTROL) {
+                ctl_receive(in_read_buffer + pos);
+            } else {
+                in_ring_push(in_read_buffer + pos);
+            }
+        }
+        in_read_carry = available - pos;
+        memmove(in_read_buffer, in_read_buffer + pos, in_read_carry);
     } else if (n < 0) {
         if (errno == EAGAIN || errno == EWOULDBLOCK) {
             // No data available
@@ -186,20 +558,431 @@ static bool pico_poll_event() {
         close(in_fd);
         in_fd = -1;
     }
+}
+
+// Bookkeeping for a packet handed to PICO-8: sequence gaps and frontend -> consumption latency
+static void in_track_consumed(const uint8_t* packet) {
+    uint32_t seq, sent_us;
+    memcpy(&seq, packet + IN_SEQ_OFFSET, 4);
+    memcpy(&sent_us, packet + IN_TIMESTAMP_OFFSET, 4);
+
+    if (in_events_consumed > 0 && seq - in_last_seq > 1 && seq - in_last_seq < 0x10000) {
+        in_seq_skipped += seq - in_last_seq - 1;
+    }
+    in_last_seq = seq;
+    in_events_consumed++;
+
+    if (sent_us != 0) {
+        uint32_t latency = wallclock_us32() - sent_us;
+        if (latency < 10000000) { // Ignore clock jumps
+            in_latency_total_us += latency;
+            in_latency_samples++;
+            if (latency > in_latency_max_us) in_latency_max_us = latency;
+        }
+    }
+
+    if (in_events_consumed % IN_STATS_INTERVAL == 0 && in_latency_samples > 0) {
+        // Skipped sequence numbers not explained by coalescing or ring overflow were lost in transit
+        long lost = (long)in_seq_skipped - (long)in_events_coalesced - (long)in_ring_dropped;
+        printf("SHIM: Input stats: %lu events, %lu coalesced, %lu dropped, %ld lost, latency avg %lu us, max %u us\n",
+               in_events_consumed, in_events_coalesced, in_ring_dropped, lost > 0 ? lost : 0,
+               (unsigned long)(in_latency_total_us / in_latency_samples), in_latency_max_us);
+        in_latency_max_us = 0;
+    }
+}
+
+// Input record / replay for repeatable benchmark and regression runs.
+// PICO_INPUT_RECORD=file logs every event handed to PICO-8 together with the present count at that moment.
+// PICO_INPUT_REPLAY=file feeds them back at the same present counts and ignores the input FIFO, so no
+// frontend is needed. Every presented frame is hashed and timed into PICO_REPLAY_LOG (default file.frames);
+// when the recording runs out a summary is printed and PICO-8 exits (PICO_REPLAY_EXIT=0 keeps it running).
+// File: "PICO8REC" + Version(4) + Pad(4), then records of Frame(4) + Event(8, the input packet's first 8 bytes).
+// Event 0 is a heartbeat written every RR_HEARTBEAT_FRAMES so a replay also covers the idle tail.
+#define RR_MAGIC "PICO8REC"
+#define RR_VERSION 1
+#define RR_HEADER_SIZE 16
+#define RR_RECORD_SIZE 12
+#define RR_HEARTBEAT_FRAMES 60
+static FILE* rr_record_file = NULL;
+static uint32_t rr_record_last_frame = 0;
+static uint8_t* rr_replay = NULL; // Whole recording, loaded at startup
+static size_t rr_replay_count = 0;
+static size_t rr_replay_pos = 0;
+static bool rr_replay_exit = true;
+static bool rr_replay_done = false;
+static FILE* rr_log_file = NULL;
+static uint64_t rr_start_us = 0;
+static uint64_t rr_last_present_us = 0;
+static uint64_t rr_frame_us_total = 0;
+static uint32_t rr_frame_us_max = 0;
+static uint64_t rr_run_hash = 0xcbf29ce484222325ull;
+
+static void rr_init() {
+    const char* record_path = getenv("PICO_INPUT_RECORD");
+    const char* replay_path = getenv("PICO_INPUT_REPLAY");
+    if (replay_path && *replay_path) {
+        FILE* f = fopen(replay_path, "rb");
+        uint8_t header[RR_HEADER_SIZE];
+        uint32_t version = 0;
+        if (!f || fread(header, 1, RR_HEADER_SIZE, f) != RR_HEADER_SIZE || memcmp(header, RR_MAGIC, 8) != 0) {
+            fprintf(stderr, "SHIM: %s is not an input recording, replay disabled\n", replay_path);
+            if (f) fclose(f);
+            return;
+        }
+        memcpy(&version, header + 8, 4);
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f) - RR_HEADER_SIZE;
+        fseek(f, RR_HEADER_SIZE, SEEK_SET);
+        rr_replay_count = size > 0 ? size / RR_RECORD_SIZE : 0;
+        rr_replay = malloc(rr_replay_count * RR_RECORD_SIZE + 1);
+        if (version != RR_VERSION || !rr_replay ||
+            fread(rr_replay, RR_RECORD_SIZE, rr_replay_count, f) != rr_replay_count) {
+            fprintf(stderr, "SHIM: Could not load input recording %s\n", replay_path);
+            free(rr_replay);
+            rr_replay = NULL;
+            rr_replay_count = 0;
+        }
+        fclose(f);
+        if (!rr_replay) return;
+
+        const char* log_path = getenv("PICO_REPLAY_LOG");
+        char default_log[PATH_MAX];
+        if (!log_path || !*log_path) {
+            snprintf(default_log, sizeof(default_log), "%s.frames", replay_path);
+            log_path = default_log;
+        }
+        rr_log_file = fopen(log_path, "w");
+        if (rr_log_file) fprintf(rr_log_file, "frame,time_us,frame_us,hash\n");
+        rr_replay_exit = !(getenv("PICO_REPLAY_EXIT") && strcmp(getenv("PICO_REPLAY_EXIT"), "0") == 0);
+        printf("SHIM: Replaying %zu input records from %s, frame log %s\n", rr_replay_count, replay_path, log_path);
+    } else if (record_path && *record_path) {
+        rr_record_file = fopen(record_path, "wb");
+        if (!rr_record_file) {
+            perror("SHIM: Failed to open input recording");
+            return;
+        }
+        uint8_t header[RR_HEADER_SIZE] = {0};
+        uint32_t version = RR_VERSION;
+        memcpy(header, RR_MAGIC, 8);
+        memcpy(header + 8, &version, 4);
+        fwrite(header, 1, RR_HEADER_SIZE, rr_record_file);
+        printf("SHIM: Recording input to %s\n", record_path);
+    }
+}
+
+static void rr_record(const uint8_t* packet) {
+    uint8_t record[RR_RECORD_SIZE];
+    memcpy(record, &vid_present_seq, 4);
+    memcpy(record + 4, packet, RR_RECORD_SIZE - 4);
+    fwrite(record, 1, RR_RECORD_SIZE, rr_record_file);
+    rr_record_last_frame = vid_present_seq;
+}
+
+// Next replayed event due at the current present count, into in_packet
+static bool rr_replay_next() {
+    while (rr_replay_pos < rr_replay_count) {
+        const uint8_t* record = rr_replay + rr_replay_pos * RR_RECORD_SIZE;
+        uint32_t frame;
+        memcpy(&frame, record, 4);
+        if (frame > vid_present_seq) return false;
+        rr_replay_pos++;
+        if (record[4] == 0) continue; // Heartbeat
+        memset(in_packet, 0, IN_PACKET_SIZE);
+        memcpy(in_packet, record + 4, RR_RECORD_SIZE - 4);
+        return true;
+    }
     return false;
 }
 
+static void rr_replay_finish() {
+    unsigned long frames = vid_present_seq;
+    printf("SHIM: Replay finished: %lu frames in %.2f s, frame avg %.2f ms, max %.2f ms, run hash %016llx\n",
+           frames, (monotonic_us() - rr_start_us) / 1e6, frames > 1 ? rr_frame_us_total / 1000.0 / (frames - 1) : 0.0,
+           rr_frame_us_max / 1000.0, (unsigned long long)rr_run_hash);
+    fflush(stdout);
+    if (rr_log_file) fclose(rr_log_file);
+    rr_log_file = NULL;
+    rr_replay_done = true;
+    if (rr_replay_exit) _exit(0);
+}
+
+// Game thread, once per present: flush the recording, or hash and time the frame during a replay
+static void rr_frame_presented(const uint32_t* pixels) {
+    if (rr_record_file) {
+        if (vid_present_seq - rr_record_last_frame >= RR_HEARTBEAT_FRAMES) {
+            uint8_t heartbeat[RR_RECORD_SIZE - 4] = {0};
+            rr_record(heartbeat);
+        }
+        fflush(rr_record_file); // PICO-8 is usually killed, not exited
+        return;
+    }
+    if (!rr_replay || rr_replay_done) return;
+
+    uint64_t now = monotonic_us();
+    uint32_t frame_us = rr_last_present_us ? (uint32_t)(now - rr_last_present_us) : 0;
+    if (!rr_start_us) rr_start_us = now;
+    rr_last_present_us = now;
+    rr_frame_us_total += frame_us;
+    if (frame_us > rr_frame_us_max) rr_frame_us_max = frame_us;
+
+    // FNV-1a over the visible RGB, the X byte of XRGB8888 is undefined
+    uint64_t hash = 0xcbf29ce484222325ull;
+    if (pixels) {
+        for (int i = 0; i < FB_WIDTH * FB_HEIGHT; i++) {
+            hash = (hash ^ (pixels[i] & 0x00FFFFFF)) * 0x100000001b3ull;
+        }
+    }
+    rr_run_hash = (rr_run_hash ^ hash) * 0x100000001b3ull;
+    if (rr_log_file) {
+        fprintf(rr_log_file, "%u,%llu,%u,%016llx\n", vid_present_seq, (unsigned long long)(now - rr_start_us),
+                frame_us, (unsigned long long)hash);
+    }
+    if (rr_replay_pos == rr_replay_count) {
+        rr_replay_finish();
+    }
+}
+
+// Try to read a packet from the client
+// Returns true if a full packet was read
+static bool pico_poll_event() {
+    if (rr_replay) {
+        return rr_replay_next();
+    }
+    if (in_ring_count == 0) {
+        in_fill_ring();
+        if (in_ring_count == 0) return false;
+    }
+
+    memcpy(in_packet, in_ring[in_ring_head], IN_PACKET_SIZE);
+    in_ring_head = (in_ring_head + 1) % IN_RING_PACKETS;
+    in_ring_count--;
+    in_track_consumed(in_packet);
+    if (rr_record_file && in_packet[0] != PIDOT_EVENT_VIDMODE) {
+        rr_record(in_packet);
+    }
+    return true;
+}
+
+// Gameplay capture (PICO_CAPTURE=file, format in capture.h). The game thread only copies each presented
+// frame into a small ring; a background thread indexes, delta-encodes and writes it. If that thread falls
+// behind, frames are dropped (counted, and visible as a SeqGap in the file) instead of holding up the game.
+#define CAP_RING_FRAMES 8
+#define CAP_KEY_INTERVAL 600 // A key record at least every 10 s at 60 fps
+#define CAP_FLUSH_INTERVAL 60 // PICO-8 is usually killed, not exited
+#define CAP_STATS_INTERVAL 3600
+
+typedef struct {
+    uint32_t seq;
+    uint64_t capture_mono_us;
+    uint8_t meta[CAP_META_SIZE];
+    bool has_pixels;
+    uint32_t pixels[CAP_WIDTH * CAP_HEIGHT];
+} CapFrame;
+
+static CapFrame* cap_ring = NULL;
+static int cap_head = 0; // Ring state under cap_mutex; the slot at head + count is the game thread's to fill
+static int cap_count = 0;
+static pthread_mutex_t cap_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cap_cond = PTHREAD_COND_INITIALIZER;
+static unsigned long cap_dropped = 0;
+
+// Capture thread only
+static FILE* cap_file = NULL;
+static uint8_t cap_index_buffers[2][CAP_WIDTH * CAP_HEIGHT];
+static uint8_t* cap_prev = NULL; // Indices of the last record, NULL until the first key record
+static CapPalette cap_palette;
+static uint8_t cap_palette_written[CAP_PALETTE_SIZE];
+static uint8_t cap_meta_written[CAP_META_SIZE];
+static uint32_t cap_last_seq = 0;
+static uint64_t cap_last_us = 0;
+static int cap_since_key = 0;
+static unsigned long cap_records = 0;
+static uint64_t cap_bytes = CAP_HEADER_SIZE;
+static uint64_t cap_encode_us = 0;
+
+static size_t cap_encode(const CapFrame* frame, uint8_t* record) {
+    uint8_t flags = 0;
+    size_t size = CAP_RECORD_HEADER_SIZE;
+    bool key = !cap_prev || ++cap_since_key >= CAP_KEY_INTERVAL;
+    uint8_t* indices = cap_index_buffers[cap_prev == cap_index_buffers[0] ? 1 : 0];
+    bool rebuilt = false;
+    if (!frame->has_pixels || !cap_index_frame(frame->pixels, indices, &cap_palette, &rebuilt)) {
+        flags |= CAP_FLAG_NO_PIXELS;
+        key = false;
+    } else if (rebuilt) {
+        key = true;
+    }
+    if (key) {
+        flags |= CAP_FLAG_KEY;
+        cap_since_key = 0;
+    }
+
+    if (key || memcmp(frame->meta, cap_meta_written, CAP_META_SIZE) != 0) {
+        flags |= CAP_FLAG_META;
+        memcpy(record + size, frame->meta, CAP_META_SIZE);
+        memcpy(cap_meta_written, frame->meta, CAP_META_SIZE);
+        size += CAP_META_SIZE;
+    }
+    if (!(flags & CAP_FLAG_NO_PIXELS)) {
+        uint8_t palette[CAP_PALETTE_SIZE];
+        cap_palette_bytes(&cap_palette, palette);
+        if (key || memcmp(palette, cap_palette_written, CAP_PALETTE_SIZE) != 0) {
+            flags |= CAP_FLAG_PALETTE;
+            memcpy(record + size, palette, CAP_PALETTE_SIZE);
+            memcpy(cap_palette_written, palette, CAP_PALETTE_SIZE);
+            size += CAP_PALETTE_SIZE;
+        }
+        uint8_t* mask = record + size;
+        size_t rows_size = CAP_ROW_MASK_SIZE;
+        memset(mask, 0, CAP_ROW_MASK_SIZE);
+        for (int y = 0; y < CAP_HEIGHT; y++) {
+            size_t n = cap_encode_row(indices + y * CAP_WIDTH, key ? NULL : cap_prev + y * CAP_WIDTH, mask + rows_size);
+            if (n) {
+                mask[y >> 3] |= (uint8_t)(1 << (y & 7));
+                rows_size += n;
+            }
+        }
+        if (rows_size > CAP_ROW_MASK_SIZE) {
+            flags |= CAP_FLAG_ROWS;
+            size += rows_size;
+        }
+        cap_prev = indices;
+    }
+
+    uint32_t gap = cap_last_seq ? frame->seq - cap_last_seq : 1;
+    uint32_t delta_us = cap_last_us ? (uint32_t)(frame->capture_mono_us - cap_last_us) : 0;
+    record[0] = flags;
+    record[1] = gap > 255 ? 255 : (uint8_t)gap;
+    memcpy(record + 2, &delta_us, 4);
+    cap_last_seq = frame->seq;
+    cap_last_us = frame->capture_mono_us;
+    return size;
+}
+
+static void* cap_thread(void* arg) {
+    (void)arg;
+    uint8_t* record = malloc(CAP_RECORD_MAX);
+    if (!record) return NULL;
+    for (;;) {
+        pthread_mutex_lock(&cap_mutex);
+        while (cap_count == 0) {
+            pthread_cond_wait(&cap_cond, &cap_mutex);
+        }
+        CapFrame* frame = &cap_ring[cap_head];
+        pthread_mutex_unlock(&cap_mutex);
+
+        uint64_t start = monotonic_us();
+        size_t size = cap_encode(frame, record);
+        cap_encode_us += monotonic_us() - start;
+
+        pthread_mutex_lock(&cap_mutex);
+        cap_head = (cap_head + 1) % CAP_RING_FRAMES;
+        cap_count--;
+        unsigned long dropped = cap_dropped;
+        pthread_mutex_unlock(&cap_mutex);
+
+        fwrite(record, 1, size, cap_file);
+        cap_bytes += size;
+        if (++cap_records % CAP_FLUSH_INTERVAL == 0) {
+            fflush(cap_file);
+        }
+        if (cap_records % CAP_STATS_INTERVAL == 0) {
+            printf("SHIM: Capture stats: %lu frames, %.1f KB (%.0f B/frame), encode %.1f us/frame, dropped %lu\n",
+                   cap_records, cap_bytes / 1024.0, (double)cap_bytes / cap_records,
+                   (double)cap_encode_us / cap_records, dropped);
+            fflush(stdout);
+        }
+    }
+    return NULL;
+}
+
+static void cap_init() {
+    const char* path = getenv("PICO_CAPTURE");
+    if (!path || !*path) return;
+    cap_file = fopen(path, "wb");
+    cap_ring = malloc(sizeof(CapFrame) * CAP_RING_FRAMES);
+    if (!cap_file || !cap_ring) {
+        perror("SHIM: Failed to start capture");
+        if (cap_file) fclose(cap_file);
+        free(cap_ring);
+        cap_file = NULL;
+        cap_ring = NULL;
+        return;
+    }
+    setvbuf(cap_file, NULL, _IOFBF, 1 << 18);
+    uint8_t header[CAP_HEADER_SIZE] = {0};
+    uint32_t version = CAP_VERSION;
+    uint16_t size[2] = {CAP_WIDTH, CAP_HEIGHT};
+    memcpy(header, CAP_MAGIC, 8);
+    memcpy(header + 8, &version, 4);
+    memcpy(header + 12, size, 4);
+    fwrite(header, 1, sizeof(header), cap_file);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, cap_thread, NULL) != 0) {
+        perror("SHIM: Failed to start capture thread");
+        fclose(cap_file);
+        free(cap_ring);
+        cap_file = NULL;
+        cap_ring = NULL;
+        return;
+    }
+    pthread_detach(thread);
+    printf("SHIM: Capturing gameplay to %s\n", path);
+}
+
+// Game thread: one copy into the ring, never waits for the writer
+static void cap_push(uint32_t seq, uint64_t capture_mono_us, const uint8_t* meta, const uint32_t* pixels) {
+    pthread_mutex_lock(&cap_mutex);
+    if (cap_count == CAP_RING_FRAMES) {
+        cap_dropped++;
+        pthread_mutex_unlock(&cap_mutex);
+        return;
+    }
+    CapFrame* frame = &cap_ring[(cap_head + cap_count) % CAP_RING_FRAMES];
+    pthread_mutex_unlock(&cap_mutex);
+
+    frame->seq = seq;
+    frame->capture_mono_us = capture_mono_us;
+    memcpy(frame->meta, meta, CAP_META_SIZE);
+    frame->has_pixels = pixels != NULL;
+    if (pixels) {
+        memcpy(frame->pixels, pixels, sizeof(frame->pixels));
+    }
+
+    pthread_mutex_lock(&cap_mutex);
+    cap_count++;
+    pthread_cond_signal(&cap_cond);
+    pthread_mutex_unlock(&cap_mutex);
+}
+
 static bool false_start = true;
+static bool aud_direct = false;
 
 DECLSPEC int SDLCALL SDL_Init(Uint32 flags) {
     static int (*realf)(Uint32) = NULL;
     FINDSDL(realf, SDL_Init);
 
+    // Direct audio: the shim runs PICO-8's callback itself, SDL never opens a real device
+    if (getenv("PICO_AUDIO_DIRECT") && strcmp(getenv("PICO_AUDIO_DIRECT"), "1") == 0) {
+        aud_direct = true;
+        setenv("SDL_AUDIODRIVER", "dummy", 1);
+    }
+    // Headless (PICO_HEADLESS=1): no window or sound device, frames only go out over the channels
+    if (getenv("PICO_HEADLESS") && strcmp(getenv("PICO_HEADLESS"), "1") == 0) {
+        setenv("SDL_VIDEODRIVER", "dummy", 1);
+        if (!aud_direct) setenv("SDL_AUDIODRIVER", "dummy", 1);
+    }
+
     if (false_start) {
         printf("false start\n");
         false_start = false;
     } else {
+        boot_mark(BOOT_SDL_INIT);
         shim_fifo_init();
+        rr_init();
+        cap_init();
+        if (in_fd >= 0) boot_mark(BOOT_INPUT_FIFO);
     }
 
     return realf(flags);
@@ -220,27 +1003,504 @@ DECLSPEC SDL_Window* SDLCALL SDL_CreateWindow(const char *title,
     if(currentsurf) {
         printf("surface format: %s\n", SDL_GetPixelFormatName(currentsurf->format->format));
     }
-    return window;
+    return window;
+}
+
+static Uint64 last_frame = 0;
+
+#define ROW_IN_MASK(mask, y) (!(mask) || ((mask)[(y) >> 3] & (1 << ((y) & 7))))
+
+// Build a palette + 4bpp index image from the XRGB surface.
+// With a row_mask only the flagged rows are encoded, packed back to back.
+// Returns false if those rows use more than 16 distinct colors (caller falls back to RGBA).
+static bool encode_indexed(const uint32_t* src32, const uint8_t* row_mask, uint8_t* palette_dst, uint8_t* pixels) {
+    uint32_t palette[PALETTE_COLORS];
+    int color_count = 0;
+    uint32_t last_color = 0xFFFFFFFF;
+    uint8_t last_index = 0;
+    int out = 0;
+
+    for (int y = 0; y < FB_HEIGHT; y++) {
+        if (!ROW_IN_MASK(row_mask, y)) continue;
+        const uint32_t* row = src32 + y * FB_WIDTH;
+        for (int x = 0; x < FB_WIDTH; x++, out++) {
+            uint32_t color = row[x] & 0x00FFFFFF;
+            if (color != last_color) {
+                int idx = 0;
+                while (idx < color_count && palette[idx] != color) idx++;
+                if (idx == color_count) {
+                    if (color_count == PALETTE_COLORS) {
+                        return false;
+                    }
+                    palette[color_count++] = color;
+                }
+                last_color = color;
+                last_index = (uint8_t)idx;
+            }
+            if (out & 1) {
+                pixels[out >> 1] |= (uint8_t)(last_index << 4);
+            } else {
+                pixels[out >> 1] = last_index;
+            }
+        }
+    }
+
+    // Palette as R, G, B bytes. Unused entries are black.
+    for (int c = 0; c < PALETTE_COLORS; c++) {
+        uint32_t color = (c < color_count) ? palette[c] : 0;
+        palette_dst[c * 3] = (color >> 16) & 0xFF;
+        palette_dst[c * 3 + 1] = (color >> 8) & 0xFF;
+        palette_dst[c * 3 + 2] = color & 0xFF;
+    }
+    return true;
+}
+
+// Convert SDL Surface (RGB888) rows to Godot (RGBA8888), packed back to back
+static pixconv_fn pixconv = NULL;
+
+static void convert_rgba(const uint32_t* src32, const uint8_t* row_mask, uint32_t* dst32) {
+    if (!pixconv) {
+        pixconv = pixconv_select();
+    }
+    if (!row_mask) {
+        pixconv(src32, dst32, FB_WIDTH * FB_HEIGHT);
+        return;
+    }
+    for (int y = 0; y < FB_HEIGHT; y++) {
+        if (!ROW_IN_MASK(row_mask, y)) continue;
+        pixconv(src32 + y * FB_WIDTH, dst32, FB_WIDTH);
+        dst32 += FB_WIDTH;
+    }
+}
+
+// Compare against the last sent frame. Fills row_mask, returns number of changed rows.
+static int diff_rows(const uint32_t* src32, uint8_t* row_mask) {
+    int changed = 0;
+    memset(row_mask, 0, ROW_MASK_SIZE);
+    for (int y = 0; y < FB_HEIGHT; y++) {
+        size_t off = (size_t)y * FB_WIDTH;
+        if (memcmp(src32 + off, last_sent_frame + off, RGBA_ROW_SIZE) != 0) {
+            row_mask[y >> 3] |= (uint8_t)(1 << (y & 7));
+            changed++;
+        }
+    }
+    return changed;
+}
+
+// Convert the frame straight into the next ring slot (seqlock publish) and fill in the doorbell payload
+static void shm_publish(const uint32_t* src32, uint8_t* doorbell) {
+    ShmSlot* slot = (ShmSlot*)(shm_base + SHM_HEADER_SIZE + (size_t)shm_next_slot * SHM_SLOT_SIZE);
+    uint32_t seq = slot->seq + 1;
+
+    __atomic_store_n(&slot->seq, seq, __ATOMIC_RELAXED); // odd: write in progress
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    if (vid_encoding == VID_ENCODING_INDEXED && encode_indexed(src32, NULL, slot->data, slot->data + PALETTE_SIZE)) {
+        slot->type = VID_PKT_INDEXED;
+        slot->length = PALETTE_SIZE + INDEXED_PIXEL_SIZE;
+    } else {
+        convert_rgba(src32, NULL, (uint32_t*)slot->data);
+        slot->type = VID_PKT_RGBA;
+        slot->length = PIXEL_SIZE;
+    }
+    seq++;
+    __atomic_store_n(&slot->seq, seq, __ATOMIC_RELEASE); // even: published
+
+    doorbell[0] = (uint8_t)shm_next_slot;
+    doorbell[1] = doorbell[2] = doorbell[3] = 0;
+    memcpy(doorbell + 4, &seq, 4);
+    shm_next_slot = (shm_next_slot + 1) % SHM_SLOTS;
+}
+
+// Latest-frame-wins handoff between PICO-8's present and the sender thread.
+// The game thread only captures into vid_back and swaps it into the mailbox;
+// the sender swaps the mailbox with vid_front and does all encoding and I/O.
+typedef struct {
+    uint32_t pixels[FB_WIDTH * FB_HEIGHT];
+    uint8_t meta[META_SIZE];
+    bool has_pixels;
+    uint32_t seq; // Present counter, gaps on the reader side are coalesced/skipped frames
+    uint32_t capture_us; // Wall clock at present, same clock as the input timestamps
+    uint64_t capture_mono_us;
+} VidFrame;
+
+static VidFrame vid_frames[3];
+static VidFrame* vid_back = &vid_frames[0];
+static VidFrame* vid_mailbox = &vid_frames[1];
+static VidFrame* vid_front = &vid_frames[2];
+static bool vid_mailbox_full = false;
+static bool vid_thread_started = false;
+static pthread_mutex_t vid_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t vid_cond = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t vid_send_mutex = PTHREAD_MUTEX_INITIALIZER; // Held while a packet is being written
+
+// Counters: coalesced = replaced in the mailbox before sending, dropped = no reader / write failed
+#define VID_STATS_INTERVAL 600
+static unsigned long vid_frames_published = 0;
+static unsigned long vid_frames_sent = 0;
+static unsigned long vid_frames_coalesced = 0;
+static unsigned long vid_frames_dropped = 0;
+static unsigned long vid_stats_frames = 0;
+
+// Telemetry window (sender thread), flushed to the reader as a 'T' packet about once a second.
+// Payload, all u32 little endian:
+// QueueAvgUs + EncodeAvgUs + WriteAvgUs + WriteMaxUs + Dropped + Coalesced + PollEventsPerSec + Sent
+#define TELEMETRY_SIZE 32
+#define VID_TELEMETRY_INTERVAL_US 1000000
+static uint64_t tel_window_start_us = 0;
+static uint64_t tel_queue_us = 0;
+static uint64_t tel_encode_us = 0;
+static uint64_t tel_write_us = 0;
+static uint32_t tel_write_max_us = 0;
+static uint32_t tel_samples = 0;
+static unsigned long tel_poll_calls_start = 0;
+static unsigned long tel_coalesced = 0; // Snapshot taken under vid_mutex
+// SDL_PollEvent calls, written by the game thread only
+static unsigned long poll_event_calls = 0;
+
+// Control acks (game thread -> sender thread, under vid_mutex). The latest state is repeated every
+// CTL_HEARTBEAT_US while paused or without video, so the reader still hears from the shim.
+#define CONTROL_SIZE 8
+#define CTL_HEARTBEAT_US 100000
+static uint8_t ctl_ack[CONTROL_SIZE];
+static bool ctl_ack_pending = false;
+
+// Single static buffer to avoid stack allocation and allow single-syscall writing (sender thread only)
+static uint8_t packet_buffer[PACKET_SIZE];
+static bool header_initialized = false;
+static int vid_open_attempts = 0;
+static bool vid_ready_pending = false; // New reader: send the 'R' packet after its first frame
+
+#define READY_SIZE (BOOT_PHASES * 4)
+
+// Readiness handshake: FIFOs are open and a frame is on its way, the frontend can stop waiting
+static void vid_send_ready() {
+    boot_mark(BOOT_FIRST_FRAME);
+    uint8_t packet[PAYLOAD_OFFSET + READY_SIZE];
+    memcpy(packet, packet_buffer, PAYLOAD_OFFSET); // Same meta/frame info as the frame packet
+    packet[VID_TYPE_INDEX] = VID_PKT_READY;
+    memcpy(packet + PAYLOAD_OFFSET, boot_us, READY_SIZE);
+    if (write_all(vid_fd, packet, sizeof(packet)) < 0) {
+        return;
+    }
+    vid_ready_pending = false;
+    printf("SHIM: Ready, first frame %.1f ms after SDL_Init (%.1f ms after load)\n",
+           (uint32_t)(boot_us[BOOT_FIRST_FRAME] - boot_us[BOOT_SDL_INIT]) / 1000.0,
+           (uint32_t)(boot_us[BOOT_FIRST_FRAME] - boot_us[BOOT_SHIM_LOAD]) / 1000.0);
+    fflush(stdout);
+}
+
+// Sender thread side: encode the captured frame and push it to the reader
+static void vid_send_frame(VidFrame* frame) {
+        // Initialize header once
+        if (!header_initialized) {
+            memcpy(packet_buffer, "PICO8SYNC__", HEADER_SIZE);
+            header_initialized = true;
+        }
+
+        // Write Metadata
+        memcpy(packet_buffer + HEADER_SIZE, frame->meta, META_SIZE);
+        memcpy(packet_buffer + HEADER_SIZE + META_SIZE, &frame->seq, 4);
+        memcpy(packet_buffer + HEADER_SIZE + META_SIZE + 4, &frame->capture_us, 4);
+        uint64_t encode_start_us = monotonic_us();
+
+        // Write Pixels
+        uint8_t* payload = packet_buffer + PAYLOAD_OFFSET;
+        const uint32_t* src32 = frame->has_pixels ? frame->pixels : NULL;
+        size_t packet_size = PACKET_SIZE;
+        uint8_t row_mask[ROW_MASK_SIZE];
+        int changed_rows = FB_HEIGHT;
+
+        if (src32 && (vid_flags & VID_FLAG_DELTA) && last_frame_valid) {
+            changed_rows = diff_rows(src32, row_mask);
+        }
+
+        if (!src32) {
+            packet_buffer[VID_TYPE_INDEX] = VID_PKT_RGBA;
+            memset(payload, 0, PIXEL_SIZE);
+        }
+        // Nothing changed: skip the frame, only a metadata keepalive now and then
+        else if (changed_rows == 0) {
+            bool meta_changed = memcmp(last_sent_meta, packet_buffer + HEADER_SIZE, META_SIZE) != 0;
+            if (!meta_changed && ++frames_since_packet < VID_KEEPALIVE_FRAMES) {
+                return;
+            }
+            packet_buffer[VID_TYPE_INDEX] = VID_PKT_KEEPALIVE;
+            packet_size = PAYLOAD_OFFSET;
+        }
+        // Shared-memory transport: pixels go to the ring, the FIFO only gets a doorbell
+        else if ((vid_flags & VID_FLAG_SHM) && shm_base) {
+            shm_publish(src32, payload);
+            packet_buffer[VID_TYPE_INDEX] = VID_PKT_SHM_FRAME;
+            packet_size = PAYLOAD_OFFSET + SHM_DOORBELL_SIZE;
+        }
+        // Some scanlines changed: send only those
+        else if (changed_rows < FB_HEIGHT) {
+            uint8_t* indexed_mask = payload + PALETTE_SIZE;
+            memcpy(indexed_mask, row_mask, ROW_MASK_SIZE);
+            if (vid_encoding == VID_ENCODING_INDEXED &&
+                encode_indexed(src32, row_mask, payload, indexed_mask + ROW_MASK_SIZE)) {
+                packet_buffer[VID_TYPE_INDEX] = VID_PKT_INDEXED_DELTA;
+                packet_size = PAYLOAD_OFFSET + PALETTE_SIZE + ROW_MASK_SIZE + changed_rows * INDEXED_ROW_SIZE;
+            } else {
+                memcpy(payload, row_mask, ROW_MASK_SIZE);
+                convert_rgba(src32, row_mask, (uint32_t*)(payload + ROW_MASK_SIZE));
+                packet_buffer[VID_TYPE_INDEX] = VID_PKT_RGBA_DELTA;
+                packet_size = PAYLOAD_OFFSET + ROW_MASK_SIZE + changed_rows * RGBA_ROW_SIZE;
+            }
+        }
+        // Indexed mode (negotiated by the frontend): ~8KB instead of 64KB per frame
+        else if (vid_encoding == VID_ENCODING_INDEXED && encode_indexed(src32, NULL, payload, payload + PALETTE_SIZE)) {
+            packet_buffer[VID_TYPE_INDEX] = VID_PKT_INDEXED;
+            packet_size = INDEXED_PACKET_SIZE;
+        }
+        else {
+            packet_buffer[VID_TYPE_INDEX] = VID_PKT_RGBA;
+            convert_rgba(src32, NULL, (uint32_t*)payload);
+        }
+        uint64_t encode_end_us = monotonic_us();
+        
+        // DIRECT FIFO SEND
+        
+        // 1. Lazy open Video FIFO
+        if (vid_fd < 0) {
+            // Non-blocking open: fails with ENXIO while there is no reader, the frame counts as dropped.
+            // Writes are blocking (flag cleared below) so we wait for Godot to clear the buffer if we exceed PIPE_BUF (64KB).
+            vid_fd = open(fifo_vid_path, O_WRONLY | O_NONBLOCK);
+            if (vid_fd >= 0) {
+                int fl = fcntl(vid_fd, F_GETFL);
+                if (fl < 0 || fcntl(vid_fd, F_SETFL, fl & ~O_NONBLOCK) < 0) {
+                    perror("SHIM: Failed to make video FIFO blocking");
+                    close(vid_fd);
+                    vid_fd = -1;
+                }
+            }
+            if (vid_fd < 0) {
+                // If ENXIO, no reader is open yet. This is expected.
+                if (errno != ENXIO) {
+                   perror("SHIM: Failed to open video FIFO");
+                } else {
+                   if (vid_open_attempts++ % 60 == 0) {
+                       printf("SHIM: Waiting for video reader (ENXIO)...\n");
+                   }
+                }
+                vid_frames_dropped++;
+                return;
+            }
+            
+            // Optimization: Increase pipe capacity to 1MB (default is 64KB)
+            // This prevents blocking when writing ~65KB frames
+            int pipe_sz = fcntl(vid_fd, F_SETPIPE_SZ, 1048576);
+            if (pipe_sz < 0) {
+                // Not fatal, just means we use default size
+                // perror("SHIM: Failed to set pipe capacity"); 
+            } else {
+                printf("SHIM: Video FIFO capacity set to %d bytes\n", pipe_sz);
+            }
+
+            printf("SHIM: Connected to Video FIFO!\n");
+            boot_mark(BOOT_VIDEO_FIFO);
+            vid_ready_pending = true;
+        }
+
+        // 2. Write Data
+        if (vid_fd >= 0) {
+            ssize_t sent = write_all(vid_fd, packet_buffer, packet_size);
+            uint32_t write_us = (uint32_t)(monotonic_us() - encode_end_us);
+            tel_queue_us += encode_start_us - frame->capture_mono_us;
+            tel_encode_us += encode_end_us - encode_start_us;
+            tel_write_us += write_us;
+            if (write_us > tel_write_max_us) tel_write_max_us = write_us;
+            tel_samples++;
+            if (sent == (ssize_t)packet_size) {
+                // Remember what the reader now has
+                frames_since_packet = 0;
+                memcpy(last_sent_meta, packet_buffer + HEADER_SIZE, META_SIZE);
+                if (src32 && changed_rows > 0) {
+                    memcpy(last_sent_frame, src32, sizeof(last_sent_frame));
+                    last_frame_valid = true;
+                }
+                vid_frames_sent++;
+                if (vid_ready_pending) {
+                    vid_send_ready();
+                }
+            } else {
+                last_frame_valid = false;
+                vid_frames_dropped++;
+            }
+            if (sent < 0) {
+                 if (errno == EPIPE) {
+                     // Reader Closed
+                     printf("SHIM: Video Pipe broken (Reader closed)\n");
+                     close(vid_fd);
+                     vid_fd = -1;
+                 } else if (errno != EAGAIN) {
+                     // Other error
+                     // perror("SHIM: Write failed");
+                 }
+            }
+        }
+}
+
+// Flush the telemetry window as a 'T' packet. Best effort: skipped while no reader is connected.
+static void vid_send_telemetry() {
+    uint64_t now = monotonic_us();
+    if (tel_window_start_us == 0) {
+        tel_window_start_us = now;
+        tel_poll_calls_start = __atomic_load_n(&poll_event_calls, __ATOMIC_RELAXED);
+        return;
+    }
+    uint64_t elapsed = now - tel_window_start_us;
+    if (elapsed < VID_TELEMETRY_INTERVAL_US || vid_fd < 0) {
+        return;
+    }
+
+    unsigned long poll_calls = __atomic_load_n(&poll_event_calls, __ATOMIC_RELAXED);
+    uint32_t samples = tel_samples ? tel_samples : 1;
+    uint32_t values[TELEMETRY_SIZE / 4] = {
+        (uint32_t)(tel_queue_us / samples),
+        (uint32_t)(tel_encode_us / samples),
+        (uint32_t)(tel_write_us / samples),
+        tel_write_max_us,
+        (uint32_t)vid_frames_dropped,
+        (uint32_t)tel_coalesced,
+        (uint32_t)((poll_calls - tel_poll_calls_start) * 1000000ull / elapsed),
+        (uint32_t)vid_frames_sent,
+    };
+    uint8_t packet[PAYLOAD_OFFSET + TELEMETRY_SIZE];
+    memcpy(packet, packet_buffer, PAYLOAD_OFFSET); // Same meta/frame info as the last frame packet
+    packet[VID_TYPE_INDEX] = VID_PKT_TELEMETRY;
+    memcpy(packet + PAYLOAD_OFFSET, values, TELEMETRY_SIZE);
+    if (write_all(vid_fd, packet, sizeof(packet)) < 0 && errno == EPIPE) {
+        close(vid_fd);
+        vid_fd = -1;
+    }
+
+    tel_window_start_us = now;
+    tel_poll_calls_start = poll_calls;
+    tel_queue_us = tel_encode_us = tel_write_us = 0;
+    tel_write_max_us = 0;
+    tel_samples = 0;
+}
+
+// Control ack or heartbeat. Dropped while no reader is connected, the state goes out again with the next one.
+static void vid_send_control(const uint8_t* ack) {
+    if (vid_fd < 0) {
+        return;
+    }
+    uint8_t packet[PAYLOAD_OFFSET + CONTROL_SIZE];
+    if (header_initialized) {
+        memcpy(packet, packet_buffer, PAYLOAD_OFFSET); // Same meta/frame info as the last frame packet
+    } else {
+        memset(packet, 0, PAYLOAD_OFFSET);
+        memcpy(packet, "PICO8SYNC__", HEADER_SIZE);
+    }
+    packet[VID_TYPE_INDEX] = VID_PKT_CONTROL;
+    memcpy(packet + PAYLOAD_OFFSET, ack, CONTROL_SIZE);
+    if (write_all(vid_fd, packet, sizeof(packet)) < 0 && errno == EPIPE) {
+        close(vid_fd);
+        vid_fd = -1;
+    }
+}
+
+// Sender thread: always takes the newest published frame, stale ones were already replaced
+static void* vid_sender_thread(void* arg) {
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&vid_mutex);
+        while (!vid_mailbox_full && !ctl_ack_pending) {
+            if (!(ctl_ack[1] & (CTL_FLAG_PAUSED | CTL_FLAG_VIDEO_OFF))) {
+                pthread_cond_wait(&vid_cond, &vid_mutex);
+                continue;
+            }
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += CTL_HEARTBEAT_US * 1000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_nsec -= 1000000000L;
+                deadline.tv_sec++;
+            }
+            if (pthread_cond_timedwait(&vid_cond, &vid_mutex, &deadline) == ETIMEDOUT) {
+                ctl_ack_pending = true;
+            }
+        }
+        if (ctl_ack_pending) {
+            uint8_t ack[CONTROL_SIZE];
+            memcpy(ack, ctl_ack, CONTROL_SIZE);
+            ctl_ack_pending = false;
+            pthread_mutex_unlock(&vid_mutex);
+            pthread_mutex_lock(&vid_send_mutex);
+            vid_send_control(ack);
+            pthread_mutex_unlock(&vid_send_mutex);
+            continue;
+        }
+        VidFrame* taken = vid_mailbox;
+        vid_mailbox = vid_front;
+        vid_front = taken;
+        vid_mailbox_full = false;
+        // Negotiation happens on the game thread, apply it between frames
+        vid_encoding = vid_req_encoding;
+        vid_flags = vid_req_flags;
+        if (vid_req_reset) {
+            vid_req_reset = false;
+            last_frame_valid = false;
+        }
+        tel_coalesced = vid_frames_coalesced;
+        pthread_mutex_unlock(&vid_mutex);
+
+        pthread_mutex_lock(&vid_send_mutex);
+        vid_send_frame(vid_front);
+        vid_send_telemetry();
+        pthread_mutex_unlock(&vid_send_mutex);
+
+        if (++vid_stats_frames % VID_STATS_INTERVAL == 0) {
+            printf("SHIM: Video stats: published %lu, sent %lu, coalesced %lu, dropped %lu\n",
+                   vid_frames_published, vid_frames_sent, vid_frames_coalesced, vid_frames_dropped);
+            fflush(stdout);
+        }
+    }
+    return NULL;
+}
+
+// Game thread, on first use
+static bool vid_start_sender() {
+    if (!vid_thread_started) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, vid_sender_thread, NULL) != 0) {
+            perror("SHIM: Failed to start video sender thread");
+            return false;
+        }
+        pthread_detach(thread);
+        vid_thread_started = true;
+        printf("SHIM: Video sender thread started\n");
+    }
+    return true;
+}
+
+// Game thread side: publish the back buffer into the single-slot mailbox and return immediately
+static void vid_publish_frame() {
+    if (!vid_start_sender()) {
+        return;
+    }
+
+    pthread_mutex_lock(&vid_mutex);
+    VidFrame* published = vid_back;
+    vid_back = vid_mailbox;
+    vid_mailbox = published;
+    if (vid_mailbox_full) {
+        // Sender hasn't picked up the previous frame yet: it is replaced, never sent
+        vid_frames_coalesced++;
+    }
+    vid_mailbox_full = true;
+    vid_frames_published++;
+    pthread_cond_signal(&vid_cond);
+    pthread_mutex_unlock(&vid_mutex);
 }
 
-static Uint64 last_frame = 0;
-
-// Single static buffer to avoid stack allocation and allow single-syscall writing
-static uint8_t packet_buffer[PACKET_SIZE];
-static bool header_initialized = false;
-static int vid_open_attempts = 0;
-
 void pico_send_vid_data() {
     if (currentsurf == NULL) {
         return;
     }
 
-        // Initialize header once
-        if (!header_initialized) {
-            memcpy(packet_buffer, "PICO8SYNC__", HEADER_SIZE);
-            header_initialized = true;
-        }
-
         uint8_t navstate = 0;
         uint8_t state_enum = 0;
         uint8_t cart_loaded = 0;
@@ -251,7 +1511,7 @@ void pico_send_vid_data() {
         uint8_t raw_volume = 128; // Default 256 / 2
 
         // Gate memory reading behind version check to prevent reading garbage/crashing
-        if (picoram != NULL && is_version_0_2_7) {
+        if (picoram != NULL && pico8_build) {
             // DAT_00640554 (Editor screen index: 0=Code, 1=Sprite, 2=Map, 3=Sfx, 4=Music)
             master_state = picoram[0x255d4]; 
             state_enum = picoram[PICORAM_INDEX_STATE_TYPE];
@@ -273,7 +1533,7 @@ void pico_send_vid_data() {
             uint8_t is_muted = 0;
             
             if (base_addr != 0) {
-                uint8_t *app_struct = (uint8_t *)(base_addr + 0x1a0e60);
+                uint8_t *app_struct = (uint8_t *)(base_addr + pico8_build->app_struct);
                 // Safe access assuming mapping is valid
                 // CORRECTION: 5080 and 5092 are DECIMAL offsets (from Ghidra naming app._5080_4_)
                 // 5080 = 0x13d8. 5092 = 0x13e4.
@@ -285,7 +1545,7 @@ void pico_send_vid_data() {
                 // cconfig is a global struct at Ghidra 0x4d86c0
                 // (The .got entry at 0x27cd50 points to it)
                 // Runtime Offset: 0x4d86c0 - 0x100000 = 0x3d86c0
-                uint8_t *cconfig_struct = (uint8_t *)(base_addr + 0x3d86c0);
+                uint8_t *cconfig_struct = (uint8_t *)(base_addr + pico8_build->cconfig);
                 
                 // cconfig._28_4_ is a 4-byte int. 0 means Muted, > 0 is Volume (e.g., 0x100)
                 uint32_t volume = *(uint32_t *)(cconfig_struct + 28);
@@ -350,10 +1610,14 @@ void pico_send_vid_data() {
             }
         }
         
-        // Write Metadata
-        packet_buffer[HEADER_SIZE] = navstate;
-        packet_buffer[HEADER_SIZE + 1] = master_state;
-        packet_buffer[HEADER_SIZE + 2] = raw_volume;
+        // Capture: metadata + raw surface into the back buffer, then hand it to the sender
+        VidFrame* frame = vid_back;
+        frame->meta[0] = navstate;
+        frame->meta[1] = master_state;
+        frame->meta[2] = raw_volume;
+        frame->seq = ++vid_present_seq;
+        frame->capture_us = wallclock_us32();
+        frame->capture_mono_us = monotonic_us();
         // We reuse the last 4 bytes of the magic string "PICO8SYNC__"
         // New Format: "PICO8SY" (7 bytes) + NaVSate(1) + MasterState(1) + Volume(1)
         //memcpy(packet_buffer, "PICO8SY", 7);
@@ -363,79 +1627,53 @@ void pico_send_vid_data() {
         //packet_buffer[10] = is_editor;
         //packet_buffer[11] = navstate;
         
-        // Write Pixels
-        // Convert SDL Surface (RGB888) to Godot (RGBA8888)
-        uint32_t* dst32 = (uint32_t*)(packet_buffer + HEADER_SIZE + META_SIZE); 
-        const uint32_t* src32 = (uint32_t*)currentsurf->pixels;
-        
-        // Safety check
-        if (src32) {
-             for (int i = 0; i < 16384; i++) {
-                uint32_t pixel = src32[i];
-                // RGB to ABGR (or whatever Godot needs, this was working before)
-                *dst32++ = ((pixel & 0x00FF0000) >> 16) | 
-                            (pixel & 0x0000FF00)         | 
-                            ((pixel & 0x000000FF) << 16) | 
-                            0xFF000000;
-             }
-        } else {
-             memset(dst32, 0, PIXEL_SIZE);
+        frame->has_pixels = (currentsurf->pixels != NULL);
+        if (frame->has_pixels) {
+            memcpy(frame->pixels, currentsurf->pixels, sizeof(frame->pixels));
         }
         
-        // DIRECT FIFO SEND
-        
-        // 1. Lazy open Video FIFO
-        if (vid_fd < 0) {
-            // OPEN IN BLOCKING MODE for video. 
-            // This ensures we wait for Godot to clear the buffer if we exceed PIPE_BUF (64KB).
-            vid_fd = open(FIFO_VID_PATH, O_WRONLY);
-            if (vid_fd < 0) {
-                // If ENXIO, no reader is open yet. This is expected.
-                if (errno != ENXIO) {
-                   perror("SHIM: Failed to open video FIFO");
-                } else {
-                   if (vid_open_attempts++ % 60 == 0) {
-                       printf("SHIM: Waiting for video reader (ENXIO)...\n");
-                   }
-                }
-                return;
-            }
-            
-            // Optimization: Increase pipe capacity to 1MB (default is 64KB)
-            // This prevents blocking when writing ~65KB frames
-            int pipe_sz = fcntl(vid_fd, F_SETPIPE_SZ, 1048576);
-            if (pipe_sz < 0) {
-                // Not fatal, just means we use default size
-                // perror("SHIM: Failed to set pipe capacity"); 
-            } else {
-                printf("SHIM: Video FIFO capacity set to %d bytes\n", pipe_sz);
-            }
-
-            printf("SHIM: Connected to Video FIFO!\n");
+        if (cap_ring) {
+            cap_push(frame->seq, frame->capture_mono_us, frame->meta, frame->has_pixels ? frame->pixels : NULL);
         }
-
-        // 2. Write Data
-        if (vid_fd >= 0) {
-            ssize_t sent = write_all(vid_fd, packet_buffer, PACKET_SIZE);
-            if (sent < 0) {
-                 if (errno == EPIPE) {
-                     // Reader Closed
-                     printf("SHIM: Video Pipe broken (Reader closed)\n");
-                     close(vid_fd);
-                     vid_fd = -1;
-                 } else if (errno != EAGAIN) {
-                     // Other error
-                     // perror("SHIM: Write failed");
-                 }
-            }
+        rr_frame_presented(frame->has_pixels ? frame->pixels : NULL);
+        if (!ctl_video_off) {
+            vid_publish_frame();
         }
+}
+
+// Snapshot requests (PIDOT_EVENT_SNAPSHOT). Queued by SDL_PollEvent and carried out by
+// snap_frame_boundary() at the start of the next present, both on the game thread.
+#define SNAP_SLOTS 4
+#define SNAP_OP_SAVE 0 // Fork a parked copy of the whole process into the slot
+#define SNAP_OP_LOAD 1 // Resume the slot's copy, this process exits
+#define SNAP_OP_DROP 2 // Free the slot
+#define SNAP_OP_WRITE 3 // Dump RAM + changed executable pages to <prefix>.snap<slot>, from a forked writer
+#define SNAP_OP_READ 4 // Copy the RAM block of <prefix>.snap<slot> back
+#define SNAP_OP_COUNT 5
+static int snap_req_op = -1;
+static int snap_req_slot = 0;
 
+static void snap_request(uint8_t op, uint8_t slot) {
+    if (op >= SNAP_OP_COUNT || slot >= SNAP_SLOTS) {
+        printf("SHIM: Ignoring snapshot request (op %d, slot %d)\n", op, slot);
+        return;
+    }
+    if (snap_req_op >= 0) {
+        printf("SHIM: Snapshot request (op %d, slot %d) replaced before the next frame\n", snap_req_op, snap_req_slot);
+    }
+    snap_req_op = op;
+    snap_req_slot = slot;
 }
 
+static void snap_frame_boundary(); // After the audio channel, it needs its lock
+static void ctl_frame_boundary();
+
 DECLSPEC int SDLCALL SDL_UpdateWindowSurface(SDL_Window * window) {
     static int (*realf)(SDL_Window*) = NULL;
     FINDSDL(realf, SDL_UpdateWindowSurface);
     // printf("we are so UpdateWindowSurfacing\n");
+    snap_frame_boundary();
+    ctl_frame_boundary();
     pico_send_vid_data();
     return realf(window);
 }
@@ -444,6 +1682,8 @@ DECLSPEC void SDLCALL SDL_RenderPresent(SDL_Renderer * renderer) {
     static void (*realf)(SDL_Renderer*) = NULL;
     FINDSDL(realf, SDL_RenderPresent);
     // printf("we are so RenderPresenting\n");
+    snap_frame_boundary();
+    ctl_frame_boundary();
     pico_send_vid_data();
     return realf(renderer);
 }
@@ -466,6 +1706,7 @@ static Uint32 lastmod = 0;
 DECLSPEC int SDLCALL SDL_PollEvent(SDL_Event * event) {
     static int (*realf)(SDL_Event* event) = NULL;
     FINDSDL(realf, SDL_PollEvent);
+    __atomic_store_n(&poll_event_calls, poll_event_calls + 1, __ATOMIC_RELAXED);
     int ret = realf(event);
     if (ret == 1) {
         // printf("event %d\n", event->type);
@@ -480,8 +1721,8 @@ DECLSPEC int SDLCALL SDL_PollEvent(SDL_Event * event) {
             }
         }
     } else {
-        int result = pico_poll_event();
-        if (result == true) {
+        // Control packets don't produce an SDL event, keep draining until one does
+        while (pico_poll_event()) {
             switch (in_packet[0])
             {
                 case PIDOT_EVENT_MOUSEEV:
@@ -536,6 +1777,25 @@ DECLSPEC int SDLCALL SDL_PollEvent(SDL_Event * event) {
                     event->text.text[0] = in_packet[1];
                     event->text.text[1] = 0;
                     return 1;
+                case PIDOT_EVENT_VIDMODE:
+                    // Mapped before the sender sees the flag (it picks it up under vid_mutex)
+                    if ((in_packet[2] & VID_FLAG_SHM) && !shm_base) {
+                        shim_shm_init();
+                    }
+                    pthread_mutex_lock(&vid_mutex);
+                    vid_req_encoding = in_packet[1];
+                    vid_req_flags = in_packet[2];
+                    // (Re)negotiation means a fresh reader: force a full frame next
+                    vid_req_reset = true;
+                    pthread_mutex_unlock(&vid_mutex);
+                    printf("SHIM: Video encoding set to %s%s%s\n",
+                           in_packet[1] == VID_ENCODING_INDEXED ? "INDEXED" : "RGBA",
+                           (in_packet[2] & VID_FLAG_DELTA) ? " + DELTA" : "",
+                           (in_packet[2] & VID_FLAG_SHM) ? (shm_base ? " + SHM" : " (SHM unavailable)") : "");
+                    break;
+                case PIDOT_EVENT_SNAPSHOT:
+                    snap_request(in_packet[1], in_packet[2]);
+                    break;
                 default:
                     break;
             }
@@ -562,6 +1822,757 @@ DECLSPEC const Uint8 *SDLCALL SDL_GetKeyboardState(int *numkeys) {
     return keystate;
 }
 
+// Direct audio channel. PICO-8 only uses the legacy SDL_OpenAudio API, so with
+// PICO_AUDIO_DIRECT=1 the shim keeps the spec, drives the callback from its own
+// timer thread and writes PCM to fifo_aud_path. No PulseAudio, no TCP.
+// Stream: header "PICO8AUD"(8) + Freq(4) + Channels(1) + Format(1) + Pad(2) each
+// time the reader connects, then interleaved frames in that format.
+#define AUD_HEADER_SIZE 16
+#define AUD_FORMAT_S16 0
+#define AUD_FORMAT_F32 1 // Godot's AudioFrame layout: the frontend pushes it without touching samples
+#define AUD_WIRE_CHANNELS 2
+#define AUD_STATS_INTERVAL 2000
+static SDL_AudioSpec aud_spec;
+static bool aud_active = false; // SDL_OpenAudio was taken over
+static bool aud_sdl_open = false; // SDL_OpenAudio went to SDL: its audio thread isn't ours to pause or restart
+static bool aud_paused = true; // As last set by PICO-8 (SDL starts paused)
+static bool aud_stopped = false; // CTL_OP_PAUSE: the direct audio thread waits on aud_resume, the FIFO goes quiet
+static pthread_cond_t aud_resume = PTHREAD_COND_INITIALIZER;
+static int aud_fd = -1;
+static pthread_mutex_t aud_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP; // SDL_LockAudio nests
+static unsigned long aud_chunks = 0;
+static unsigned long aud_chunks_dropped = 0;
+
+static bool aud_open_fifo() {
+    aud_fd = open(fifo_aud_path, O_WRONLY | O_NONBLOCK);
+    if (aud_fd < 0) {
+        return false; // ENXIO: no reader yet
+    }
+    uint8_t header[AUD_HEADER_SIZE] = {0};
+    uint32_t freq = (uint32_t)aud_spec.freq;
+    memcpy(header, "PICO8AUD", 8);
+    memcpy(header + 8, &freq, 4);
+    header[12] = AUD_WIRE_CHANNELS;
+    header[13] = AUD_FORMAT_F32;
+    if (write(aud_fd, header, sizeof(header)) != sizeof(header)) {
+        close(aud_fd);
+        aud_fd = -1;
+        return false;
+    }
+    printf("SHIM: Connected to Audio FIFO (%d Hz, %d ch)\n", aud_spec.freq, aud_spec.channels);
+    return true;
+}
+
+// s16 mono/stereo -> f32 stereo, done here so the GDScript side needs no per-sample loop
+static void aud_to_stereo_f32(const int16_t* src, float* dst, int frames, int channels) {
+    const float scale = 1.0f / 32768.0f;
+    if (channels == 1) {
+        for (int i = 0; i < frames; i++) {
+            dst[i * 2] = dst[i * 2 + 1] = src[i] * scale;
+        }
+    } else {
+        for (int i = 0; i < frames * 2; i++) {
+            dst[i] = src[i] * scale;
+        }
+    }
+}
+
+// Write one converted buffer in PIPE_BUF pieces so each piece is all-or-nothing.
+// A full FIFO means the frontend is behind: drop the rest instead of adding latency.
+static void aud_write_chunk(const uint8_t* data, size_t len) {
+    size_t frame_bytes = AUD_WIRE_CHANNELS * sizeof(float);
+    size_t piece_max = PIPE_BUF - PIPE_BUF % frame_bytes;
+    for (size_t off = 0; off < len; off += piece_max) {
+        size_t piece = (len - off < piece_max) ? len - off : piece_max;
+        ssize_t sent = write(aud_fd, data + off, piece);
+        if (sent < 0) {
+            if (errno == EPIPE) {
+                printf("SHIM: Audio Pipe broken (Reader closed)\n");
+                close(aud_fd);
+                aud_fd = -1;
+            }
+            aud_chunks_dropped++;
+            return;
+        }
+    }
+}
+
+static void* aud_thread(void* arg) {
+    (void)arg;
+    // Keep EPIPE as an error return instead of a process-killing SIGPIPE
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    uint8_t* chunk = malloc(aud_spec.size);
+    size_t wire_size = (size_t)aud_spec.samples * AUD_WIRE_CHANNELS * sizeof(float);
+    float* wire = malloc(wire_size);
+    if (!chunk || !wire) return NULL;
+    long period_ns = (long)((uint64_t)aud_spec.samples * 1000000000ull / (uint64_t)aud_spec.freq);
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    for (;;) {
+        pthread_mutex_lock(&aud_mutex);
+        if (aud_stopped) {
+            while (aud_stopped) {
+                pthread_cond_wait(&aud_resume, &aud_mutex);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &next); // Start over, the time spent stopped is not owed
+        }
+        pthread_mutex_unlock(&aud_mutex);
+
+        next.tv_nsec += period_ns;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        // Woke up far too late (process was stopped): resync instead of bursting callbacks
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t late_ns = (int64_t)(now.tv_sec - next.tv_sec) * 1000000000LL + (now.tv_nsec - next.tv_nsec);
+        if (late_ns > 4 * (int64_t)period_ns) {
+            next = now;
+        }
+
+        // The callback also advances PICO-8's music, so it runs even with no reader
+        pthread_mutex_lock(&aud_mutex);
+        if (aud_paused) {
+            memset(chunk, aud_spec.silence, aud_spec.size);
+        } else {
+            aud_spec.callback(aud_spec.userdata, chunk, (int)aud_spec.size);
+        }
+        pthread_mutex_unlock(&aud_mutex);
+
+        if (aud_fd >= 0 || aud_open_fifo()) {
+            aud_to_stereo_f32((const int16_t*)chunk, wire, aud_spec.samples, aud_spec.channels);
+            aud_write_chunk((const uint8_t*)wire, wire_size);
+        }
+        if (++aud_chunks % AUD_STATS_INTERVAL == 0) {
+            printf("SHIM: Audio stats: chunks %lu, dropped %lu\n", aud_chunks, aud_chunks_dropped);
+            fflush(stdout);
+        }
+    }
+    return NULL;
+}
+
+static bool aud_start_thread() {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, aud_thread, NULL) != 0) {
+        perror("SHIM: Failed to start audio thread");
+        return false;
+    }
+    pthread_detach(thread);
+    return true;
+}
+
+static int aud_open_sdl(int (*realf)(SDL_AudioSpec*, SDL_AudioSpec*), SDL_AudioSpec* desired, SDL_AudioSpec* obtained) {
+    int ret = realf(desired, obtained);
+    if (ret == 0) aud_sdl_open = true;
+    return ret;
+}
+
+DECLSPEC int SDLCALL SDL_OpenAudio(SDL_AudioSpec* desired, SDL_AudioSpec* obtained) {
+    static int (*realf)(SDL_AudioSpec*, SDL_AudioSpec*) = NULL;
+    FINDSDL(realf, SDL_OpenAudio);
+    // Only s16 is produced natively; other formats are fine if the caller takes what it gets
+    bool format_ok = desired->format == AUDIO_S16SYS || obtained != NULL;
+    if (!aud_direct || aud_active || !desired->callback || !format_ok ||
+        desired->channels < 1 || desired->channels > 2 || desired->freq <= 0 || desired->samples == 0) {
+        return aud_open_sdl(realf, desired, obtained);
+    }
+
+    aud_spec = *desired;
+    aud_spec.format = AUDIO_S16SYS;
+    aud_spec.silence = 0;
+    aud_spec.size = (Uint32)aud_spec.samples * aud_spec.channels * 2;
+    if (obtained) {
+        *obtained = aud_spec;
+    }
+
+    if (!aud_start_thread()) {
+        return aud_open_sdl(realf, desired, obtained);
+    }
+    aud_active = true;
+    printf("SHIM: Direct audio: %d Hz, %d ch, %d samples per callback\n",
+           aud_spec.freq, aud_spec.channels, aud_spec.samples);
+    return 0;
+}
+
+DECLSPEC void SDLCALL SDL_PauseAudio(int pause_on) {
+    static void (*realf)(int) = NULL;
+    FINDSDL(realf, SDL_PauseAudio);
+    if (!aud_active) {
+        aud_paused = (pause_on != 0);
+        realf(aud_paused || ctl_paused);
+        return;
+    }
+    pthread_mutex_lock(&aud_mutex);
+    aud_paused = (pause_on != 0);
+    pthread_mutex_unlock(&aud_mutex);
+}
+
+// Audio stops with the game while it is paused (CTL_OP_PAUSE), and resumes in PICO-8's own pause state
+static void aud_suspend(bool suspend) {
+    if (aud_active) {
+        pthread_mutex_lock(&aud_mutex);
+        aud_stopped = suspend;
+        pthread_cond_signal(&aud_resume);
+        pthread_mutex_unlock(&aud_mutex);
+        return;
+    }
+    static void (*realf)(int) = NULL;
+    FINDSDL(realf, SDL_PauseAudio);
+    realf(suspend || aud_paused);
+}
+
+DECLSPEC void SDLCALL SDL_LockAudio(void) {
+    static void (*realf)(void) = NULL;
+    FINDSDL(realf, SDL_LockAudio);
+    if (!aud_active) {
+        realf();
+        return;
+    }
+    pthread_mutex_lock(&aud_mutex);
+}
+
+DECLSPEC void SDLCALL SDL_UnlockAudio(void) {
+    static void (*realf)(void) = NULL;
+    FINDSDL(realf, SDL_UnlockAudio);
+    if (!aud_active) {
+        realf();
+        return;
+    }
+    pthread_mutex_unlock(&aud_mutex);
+}
+
+// Control channel (PIDOT_EVENT_CONTROL): the frontend suspends, throttles or blanks PICO-8 from inside its
+// own loop instead of stopping the process. Each packet is acknowledged with a 'C' video packet echoing its
+// Token next to the resulting state. Pause and the frame-rate cap act at the start of the next present,
+// audio stops and starts as soon as the packet is read.
+#define CTL_REOPEN_POLL_MS 100 // Paused with no input FIFO writer: retry the open this often
+static uint64_t ctl_next_frame_us = 0;
+
+static void ctl_receive(const uint8_t* packet) {
+    uint8_t op = packet[1], arg = packet[2];
+    in_track_consumed(packet);
+    switch (op) {
+    case CTL_OP_PAUSE:
+    case CTL_OP_RESUME:
+        if (ctl_paused != (op == CTL_OP_PAUSE)) {
+            ctl_paused = (op == CTL_OP_PAUSE);
+            aud_suspend(ctl_paused);
+        }
+        break;
+    case CTL_OP_FPS_CAP:
+        ctl_fps_cap = arg;
+        ctl_next_frame_us = 0;
+        if (arg) {
+            printf("SHIM: Frame rate capped at %d fps\n", arg);
+        } else {
+            printf("SHIM: Frame rate cap off\n");
+        }
+        break;
+    case CTL_OP_VIDEO:
+        if (ctl_video_off && arg) {
+            pthread_mutex_lock(&vid_mutex);
+            vid_req_reset = true; // The reader's last frame is stale: a full one first
+            pthread_mutex_unlock(&vid_mutex);
+        }
+        ctl_video_off = (arg == 0);
+        printf("SHIM: Video output %s\n", ctl_video_off ? "off" : "on");
+        break;
+    default:
+        printf("SHIM: Ignoring control op %d\n", op);
+        break;
+    }
+
+    pthread_mutex_lock(&vid_mutex);
+    ctl_ack[0] = packet[3];
+    ctl_ack[1] = (ctl_paused ? CTL_FLAG_PAUSED : 0) | (ctl_video_off ? CTL_FLAG_VIDEO_OFF : 0);
+    ctl_ack[2] = ctl_fps_cap;
+    ctl_ack[3] = 0;
+    memcpy(ctl_ack + 4, &vid_present_seq, 4);
+    ctl_ack_pending = true;
+    pthread_cond_signal(&vid_cond);
+    pthread_mutex_unlock(&vid_mutex);
+    vid_start_sender();
+}
+
+// Start of a present, game thread. Paused: sleep in poll() on the input FIFO until RESUME comes in.
+static void ctl_frame_boundary() {
+    if (ctl_paused) {
+        printf("SHIM: Paused at frame %u\n", vid_present_seq);
+        fflush(stdout);
+        uint64_t paused_us = monotonic_us();
+        while (ctl_paused) {
+            if (in_fd >= 0) {
+                struct pollfd pfd = { .fd = in_fd, .events = POLLIN };
+                poll(&pfd, 1, -1);
+            } else {
+                usleep(CTL_REOPEN_POLL_MS * 1000);
+            }
+            in_fill_ring();
+        }
+        printf("SHIM: Resumed after %.1f s\n", (monotonic_us() - paused_us) / 1000000.0);
+        ctl_next_frame_us = 0;
+    }
+
+    if (ctl_fps_cap) {
+        uint64_t period_us = 1000000 / ctl_fps_cap;
+        uint64_t now = monotonic_us();
+        if (now < ctl_next_frame_us) {
+            struct timespec until = {
+                .tv_sec = (time_t)(ctl_next_frame_us / 1000000),
+                .tv_nsec = (long)(ctl_next_frame_us % 1000000) * 1000,
+            };
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL) == EINTR) {
+            }
+            now = ctl_next_frame_us;
+        }
+        // Keep the cadence, unless a whole period was missed (PICO-8 itself is slower than the cap)
+        ctl_next_frame_us = (now - ctl_next_frame_us < period_us ? ctl_next_frame_us : now) + period_us;
+    }
+}
+
+// Snapshots. SAVE forks at a frame boundary. The parent stays behind, parked, as the snapshot: a
+// copy-on-write image of the whole emulator that costs one fork and then only the pages the game
+// changes afterwards. The child carries on as the running game with fresh sender/audio threads.
+// LOAD hands the channels (and any input already read) to a parked process, which resumes where it
+// was saved, and exits. The resumed process forks again right away, so a slot can be loaded any
+// number of times.
+// The process the launcher started (root) only ever parks, never exits early, so the launcher and
+// proot's --kill-on-exit keep seeing it alive. Parked processes poll the running one. When it exits
+// cleanly (shim destructor) they quit, root last. When it dies without a handoff (crash, OOM kill)
+// they quit as well, unless PICO_SNAPSHOT_RECOVER=1: then the newest snapshot takes over.
+// PICO-8's own non-SDL threads aren't known to the shim, only the video sender and direct audio
+// (PICO_AUDIO_DIRECT=1) threads are quiesced in a parked process and restarted in the running one.
+#define SNAP_PARK_POLL_MS 250
+#define SNAP_HANDOFF_TIMEOUT_MS 2000
+#define SNAP_CHILDREN_MAX 16
+
+// Shared by every process of the session (MAP_SHARED, inherited across forks)
+typedef struct {
+    uint32_t active; // Futex word: pid running the game
+    uint32_t closing; // Clean exit of the running process
+    uint32_t resumed; // Futex word: pid that took over after a LOAD
+    pid_t root;
+    pid_t slots[SNAP_SLOTS]; // Parked process per slot, 0 = empty
+    uint32_t frames[SNAP_SLOTS]; // vid_present_seq when saved
+    uint32_t order[SNAP_SLOTS]; // Save counter, the newest snapshot recovers a crash
+    uint32_t next_order;
+    // Input the loading process had read but not handed to PICO-8 yet
+    uint8_t in_ring[IN_RING_PACKETS][IN_PACKET_SIZE];
+    uint32_t in_ring_count;
+    uint8_t in_carry[IN_PACKET_SIZE];
+    uint32_t in_carry_len;
+    uint32_t in_last_seq;
+} SnapTable;
+
+static SnapTable* snap_table = NULL;
+static bool snap_recover = false;
+static pid_t snap_children[SNAP_CHILDREN_MAX]; // Forked by this process, reaped at frame boundaries / while parked
+static int snap_child_count = 0;
+
+static bool snap_init() {
+    if (snap_table) return true;
+    void* table = mmap(NULL, sizeof(SnapTable), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (table == MAP_FAILED) {
+        perror("SHIM: Failed to map snapshot table");
+        return false;
+    }
+    snap_table = table;
+    snap_table->root = getpid();
+    snap_table->active = (uint32_t)getpid();
+    const char* recover = getenv("PICO_SNAPSHOT_RECOVER");
+    snap_recover = recover && strcmp(recover, "1") == 0;
+    return true;
+}
+
+static void snap_futex_wait(uint32_t* word, uint32_t value, int timeout_ms) {
+    struct timespec ts = {timeout_ms / 1000, (long)(timeout_ms % 1000) * 1000000L};
+    syscall(SYS_futex, word, FUTEX_WAIT, value, &ts, NULL, 0);
+}
+
+static void snap_futex_wake(uint32_t* word) {
+    syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+static void snap_reap_children() {
+    for (int i = 0; i < snap_child_count; ) {
+        int status;
+        pid_t pid = waitpid(snap_children[i], &status, WNOHANG);
+        if (pid == 0) {
+            i++;
+            continue;
+        }
+        if (pid > 0 && WIFSIGNALED(status)) {
+            printf("SHIM: Snapshot process %d killed by signal %d\n", (int)pid, WTERMSIG(status));
+        }
+        snap_children[i] = snap_children[--snap_child_count];
+    }
+}
+
+static void snap_track_child(pid_t pid) {
+    if (snap_child_count == SNAP_CHILDREN_MAX) {
+        snap_reap_children();
+    }
+    if (snap_child_count < SNAP_CHILDREN_MAX) {
+        snap_children[snap_child_count++] = pid;
+    }
+}
+
+// Root is never killed, it only gives up the slot
+static void snap_drop(int slot) {
+    pid_t pid = snap_table->slots[slot];
+    if (!pid) return;
+    snap_table->slots[slot] = 0;
+    if (pid != snap_table->root) {
+        kill(pid, SIGKILL);
+    }
+    snap_reap_children();
+}
+
+static int snap_newest_slot() {
+    int newest = -1;
+    for (int i = 0; i < SNAP_SLOTS; i++) {
+        if (snap_table->slots[i] && (newest < 0 || snap_table->order[i] > snap_table->order[newest])) newest = i;
+    }
+    return newest;
+}
+
+// Quiesce the other threads: audio callback, then the sender between two packets
+static void snap_lock_threads() {
+    if (aud_active) pthread_mutex_lock(&aud_mutex);
+    pthread_mutex_lock(&vid_mutex);
+    pthread_mutex_lock(&vid_send_mutex);
+}
+
+static void snap_unlock_threads() {
+    pthread_mutex_unlock(&vid_send_mutex);
+    pthread_mutex_unlock(&vid_mutex);
+    if (aud_active) pthread_mutex_unlock(&aud_mutex);
+}
+
+// Fork child: only this thread exists, the locks its parent holds are reset and the threads restarted
+static void snap_child_reinit() {
+    pthread_mutex_t recursive = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+    pthread_mutex_t plain = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+    aud_mutex = recursive;
+    aud_resume = cond;
+    vid_mutex = plain;
+    vid_send_mutex = plain;
+    vid_cond = cond;
+    vid_thread_started = false; // Restarted by the next vid_publish_frame
+    if (aud_active && !aud_start_thread()) {
+        aud_active = false;
+    }
+    snap_child_count = 0;
+}
+
+// Parked until this process is made the running one. Returns false if it should exit instead.
+static bool snap_park(int slot) {
+    pid_t self = getpid();
+    for (;;) {
+        snap_reap_children();
+        uint32_t active = __atomic_load_n(&snap_table->active, __ATOMIC_ACQUIRE);
+        if (active == (uint32_t)self) return true;
+        if (__atomic_load_n(&snap_table->closing, __ATOMIC_ACQUIRE)) return false;
+        if (kill((pid_t)active, 0) != 0 && errno == ESRCH) {
+            // The running process is gone without handing over
+            if (!snap_recover) return false;
+            if (snap_table->slots[slot] == self && snap_newest_slot() == slot &&
+                __atomic_compare_exchange_n(&snap_table->active, &active, (uint32_t)self, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                printf("SHIM: Process %u died, recovering from snapshot %d (frame %u)\n", active, slot, snap_table->frames[slot]);
+                snap_futex_wake(&snap_table->active);
+                return true;
+            }
+        }
+        snap_futex_wait(&snap_table->active, active, SNAP_PARK_POLL_MS);
+    }
+}
+
+// After a LOAD: take over the input the previous process had queued, drop stale state from save time
+static void snap_take_over() {
+    in_ring_head = 0;
+    in_ring_count = (int)snap_table->in_ring_count;
+    memcpy(in_ring, snap_table->in_ring, sizeof(in_ring));
+    in_read_carry = snap_table->in_carry_len;
+    memcpy(in_read_buffer, snap_table->in_carry, in_read_carry);
+    in_last_seq = snap_table->in_last_seq;
+    memset(keystate, 0, sizeof(keystate));
+    mouseb = 0;
+    lastmod = 0;
+    vid_req_reset = true; // Under vid_mutex (snap_lock_threads): the reader gets a full frame first
+    __atomic_store_n(&snap_table->resumed, (uint32_t)getpid(), __ATOMIC_RELEASE);
+    snap_futex_wake(&snap_table->resumed);
+}
+
+// SDL's own audio thread doesn't survive a fork: the copy would play silently while the parked one kept
+// running PICO-8's audio callback, or deadlock on a mixer lock held at fork time. Direct audio only.
+static bool snap_audio_forkable() {
+    if (!aud_sdl_open) return true;
+    printf("SHIM: Snapshots need direct audio (PICO_AUDIO_DIRECT=1), PICO-8 is playing through SDL\n");
+    return false;
+}
+
+static void snap_save(int slot) {
+    if (rr_record_file || rr_replay || cap_ring) {
+        printf("SHIM: Snapshots are disabled while recording or replaying input or capturing\n");
+        return;
+    }
+    if (!snap_audio_forkable()) return;
+    if (!snap_init()) return;
+    if (snap_table->slots[slot]) snap_drop(slot);
+    bool resumed = false;
+    for (;;) {
+        uint64_t start = monotonic_us();
+        fflush(stdout);
+        fflush(stderr);
+        snap_lock_threads();
+        pid_t pid = fork();
+        if (pid < 0) {
+            snap_unlock_threads();
+            perror("SHIM: Snapshot fork failed");
+            return;
+        }
+        if (pid == 0) {
+            snap_child_reinit();
+            // The parent makes us the running process before it parks
+            uint32_t self = (uint32_t)getpid(), active;
+            while ((active = __atomic_load_n(&snap_table->active, __ATOMIC_ACQUIRE)) != self) {
+                snap_futex_wait(&snap_table->active, active, 10);
+            }
+            printf("SHIM: Snapshot %d %s at frame %u (fork %.2f ms, running as pid %u)\n", slot,
+                   resumed ? "loaded" : "saved", snap_table->frames[slot], (monotonic_us() - start) / 1000.0, self);
+            return;
+        }
+
+        snap_track_child(pid);
+        if (!resumed) {
+            snap_table->slots[slot] = getpid();
+            snap_table->frames[slot] = vid_present_seq;
+            snap_table->order[slot] = ++snap_table->next_order;
+        }
+        __atomic_store_n(&snap_table->active, (uint32_t)pid, __ATOMIC_RELEASE);
+        snap_futex_wake(&snap_table->active);
+
+        if (!snap_park(slot)) {
+            _exit(getpid() == snap_table->root && !snap_table->closing ? 1 : 0);
+        }
+        // Resumed: this process runs the game again. Leave a fresh copy in the slot.
+        snap_take_over();
+        snap_unlock_threads();
+        resumed = true;
+    }
+}
+
+static void snap_load(int slot) {
+    if (!snap_audio_forkable()) return;
+    pid_t target = snap_table ? snap_table->slots[slot] : 0;
+    if (!target || (kill(target, 0) != 0 && errno == ESRCH)) {
+        printf("SHIM: Snapshot slot %d is empty\n", slot);
+        if (target) snap_table->slots[slot] = 0;
+        return;
+    }
+    uint64_t start = monotonic_us();
+    snap_lock_threads(); // No more packets from this process
+    snap_table->in_ring_count = (uint32_t)in_ring_count;
+    for (int i = 0; i < in_ring_count; i++) {
+        memcpy(snap_table->in_ring[i], in_ring[(in_ring_head + i) % IN_RING_PACKETS], IN_PACKET_SIZE);
+    }
+    snap_table->in_carry_len = (uint32_t)in_read_carry;
+    memcpy(snap_table->in_carry, in_read_buffer, in_read_carry);
+    snap_table->in_last_seq = in_last_seq;
+    __atomic_store_n(&snap_table->resumed, 0, __ATOMIC_RELEASE);
+    printf("SHIM: Loading snapshot %d (frame %u), handing over to pid %d\n", slot, snap_table->frames[slot], (int)target);
+    fflush(stdout);
+    __atomic_store_n(&snap_table->active, (uint32_t)target, __ATOMIC_RELEASE);
+    snap_futex_wake(&snap_table->active);
+
+    uint32_t resumed;
+    while ((resumed = __atomic_load_n(&snap_table->resumed, __ATOMIC_ACQUIRE)) != (uint32_t)target) {
+        if (monotonic_us() - start > SNAP_HANDOFF_TIMEOUT_MS * 1000ull) break;
+        snap_futex_wait(&snap_table->resumed, resumed, 50);
+    }
+    if (resumed == (uint32_t)target) {
+        _exit(0); // No atexit handlers: PICO-8 is carrying on in the other process
+    }
+    uint32_t expected = (uint32_t)target;
+    __atomic_compare_exchange_n(&snap_table->active, &expected, (uint32_t)getpid(), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    snap_unlock_threads();
+    printf("SHIM: Snapshot %d did not resume, carrying on\n", slot);
+}
+
+// On-disk form, little endian: "PICO8SNP"(8) + Version(4) + ExeSize(4) + RamSize(4) + PageSize(4) +
+// PageCount(4) + Frame(4), the RAM block, then PageCount x (Offset(4, from base_addr) + page) for the
+// pages of the executable's writable segments that differ from what was loaded from the file. Those
+// hold heap pointers that are only valid in the process that wrote them, so READ restores the RAM
+// block only; the pages are there to diff and inspect.
+#define SNAP_FILE_MAGIC "PICO8SNP"
+#define SNAP_FILE_VERSION 1
+#define SNAP_FILE_HEADER_SIZE 32
+
+static void snap_file_path(int slot, char* path, size_t size) {
+    const char* prefix = getenv("PICO_SNAPSHOT_PREFIX");
+    if (prefix && *prefix) {
+        snprintf(path, size, "%s.snap%d", prefix, slot);
+    } else {
+        // Next to the channels
+        snprintf(path, size, "%.*s.snap%d", (int)(strlen(fifo_vid_path) - strlen(".vid")), fifo_vid_path, slot);
+    }
+}
+
+typedef struct {
+    FILE* out;
+    int exe_fd;
+    uint8_t* page;
+    uint8_t* image;
+    uint32_t pages;
+} SnapDump;
+
+static int snap_dump_handler(struct dl_phdr_info* info, size_t size, void* data) {
+    (void)size;
+    SnapDump* dump = data;
+    if (info->dlpi_addr != base_addr) return 0;
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr)* ph = &info->dlpi_phdr[i];
+        if (ph->p_type != PT_LOAD || !(ph->p_flags & PF_W)) continue;
+        uintptr_t seg = base_addr + ph->p_vaddr;
+        uintptr_t file_end = seg + ph->p_filesz;
+        for (uintptr_t addr = seg & ~(page_size - 1); addr < seg + ph->p_memsz; addr += page_size) {
+            // Load image of this page: file bytes where the segment has them, zero (bss) elsewhere
+            memset(dump->image, 0, page_size);
+            uintptr_t from = addr < seg ? seg : addr;
+            uintptr_t to = addr + page_size < file_end ? addr + page_size : file_end;
+            if (from < to) {
+                pread(dump->exe_fd, dump->image + (from - addr), to - from, ph->p_offset + (from - seg));
+            }
+            // Bytes before the segment start belong to another mapping, keep them out of the compare
+            size_t skip = addr < seg ? seg - addr : 0;
+            memset(dump->page, 0, skip);
+            memcpy(dump->page + skip, (const void*)(addr + skip), page_size - skip);
+            if (memcmp(dump->page, dump->image, page_size) == 0) continue;
+            uint32_t offset = (uint32_t)(addr - base_addr);
+            fwrite(&offset, 4, 1, dump->out);
+            fwrite(dump->page, 1, page_size, dump->out);
+            dump->pages++;
+        }
+    }
+    return 1;
+}
+
+// Runs in a forked writer: the game keeps going while this copy-on-write image is written out
+static int snap_write_file(const char* path, uint32_t frame) {
+    char tmp[PATH_MAX + 8];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    SnapDump dump = {fopen(tmp, "wb"), open("/proc/self/exe", O_RDONLY), malloc(page_size), malloc(page_size), 0};
+    if (!dump.out || dump.exe_fd < 0 || !dump.page || !dump.image) {
+        perror("SHIM: Snapshot write failed");
+        return 1;
+    }
+    uint8_t header[SNAP_FILE_HEADER_SIZE] = {0};
+    uint32_t values[6] = {SNAP_FILE_VERSION, (uint32_t)pico8_build->exe_size, (uint32_t)picoram_size, (uint32_t)page_size, 0, frame};
+    memcpy(header, SNAP_FILE_MAGIC, 8);
+    memcpy(header + 8, values, sizeof(values));
+    fwrite(header, 1, sizeof(header), dump.out);
+    fwrite(picoram, 1, picoram_size, dump.out);
+    if (base_addr) dl_iterate_phdr(snap_dump_handler, &dump);
+    // Page count goes back into the header
+    fseek(dump.out, 8 + 4 * 4, SEEK_SET);
+    fwrite(&dump.pages, 4, 1, dump.out);
+    if (fclose(dump.out) != 0 || rename(tmp, path) != 0) {
+        perror("SHIM: Snapshot write failed");
+        unlink(tmp);
+        return 1;
+    }
+    printf("SHIM: Snapshot written to %s (RAM + %u changed pages)\n", path, dump.pages);
+    return 0;
+}
+
+static void snap_write(int slot) {
+    if (!picoram || !pico8_build) {
+        printf("SHIM: Snapshot files need a known PICO-8 build with its RAM located\n");
+        return;
+    }
+    char path[PATH_MAX];
+    snap_file_path(slot, path, sizeof(path));
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        int status = snap_write_file(path, vid_present_seq);
+        fflush(stdout);
+        _exit(status);
+    }
+    if (pid < 0) {
+        perror("SHIM: Snapshot writer fork failed");
+        return;
+    }
+    snap_track_child(pid);
+}
+
+static void snap_read(int slot) {
+    if (!picoram || !pico8_build) {
+        printf("SHIM: Snapshot files need a known PICO-8 build with its RAM located\n");
+        return;
+    }
+    char path[PATH_MAX];
+    snap_file_path(slot, path, sizeof(path));
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        printf("SHIM: No snapshot file %s\n", path);
+        return;
+    }
+    uint8_t header[SNAP_FILE_HEADER_SIZE];
+    uint32_t values[6];
+    uint8_t* ram = malloc(picoram_size);
+    bool ok = ram && fread(header, 1, sizeof(header), f) == sizeof(header) && memcmp(header, SNAP_FILE_MAGIC, 8) == 0;
+    if (ok) {
+        memcpy(values, header + 8, sizeof(values));
+        ok = values[0] == SNAP_FILE_VERSION && values[1] == (uint32_t)pico8_build->exe_size &&
+             values[2] == (uint32_t)picoram_size && fread(ram, 1, picoram_size, f) == picoram_size;
+    }
+    fclose(f);
+    if (ok) {
+        memcpy(picoram, ram, picoram_size);
+        printf("SHIM: Snapshot RAM restored from %s (frame %u)\n", path, values[5]);
+    } else {
+        printf("SHIM: %s is not a snapshot of this PICO-8 build\n", path);
+    }
+    free(ram);
+}
+
+static void snap_frame_boundary() {
+    if (snap_child_count) snap_reap_children();
+    if (snap_req_op < 0) return;
+    int op = snap_req_op, slot = snap_req_slot;
+    snap_req_op = -1;
+    switch (op) {
+    case SNAP_OP_SAVE: snap_save(slot); break;
+    case SNAP_OP_LOAD: snap_load(slot); break;
+    case SNAP_OP_DROP:
+        if (snap_table) snap_drop(slot);
+        printf("SHIM: Snapshot %d dropped\n", slot);
+        break;
+    case SNAP_OP_WRITE: snap_write(slot); break;
+    case SNAP_OP_READ: snap_read(slot); break;
+    }
+}
+
+// PICO-8 quitting normally: parked snapshots follow
+__attribute__((destructor)) static void snap_unload() {
+    if (snap_table && snap_table->active == (uint32_t)getpid()) {
+        __atomic_store_n(&snap_table->closing, 1, __ATOMIC_RELEASE);
+        snap_futex_wake(&snap_table->active);
+    }
+}
+
 // static bool recursive_malloc = false;
 // void *malloc (size_t __size) {
 //     static void* (*realf)(size_t) = NULL;
@@ -573,18 +2584,3 @@ DECLSPEC const Uint8 *SDLCALL SDL_GetKeyboardState(int *numkeys) {
 //     }
 //     return realf(__size);
 // }
-
-void *memset (void *__s, int __c, size_t __n) {
-    static void* (*realf)(void*, int, size_t) = NULL;
-    FINDSDL(realf, memset);
-    
-    // PICO-8 0.2.7 RAM allocation size: 0x37000 (225280 bytes)
-    if (__c == 0 && __n == 0x37000) {
-        if (picoram == NULL) {
-             picoram = __s;
-             picoram_size = __n;
-             printf("SHIM: PICO-8 RAM Locked: %p (Size %zx)\n", picoram, picoram_size);
-        }
-    }
-    return realf(__s, __c, __n);
-}
\ No newline at end of file
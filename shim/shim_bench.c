@@ -0,0 +1,646 @@
+// Host benchmark for the shim's video/input channels, no PICO-8 or device needed.
+// Build: gcc -O2 -shared -fPIC -o libmocksdl.so mock_sdl.c
+//        gcc -O3 -pthread -o shim_bench shim_bench.c -L. -l:picoshim.so -l:libmocksdl.so -ldl -Wl,-rpath,'$ORIGIN'
+// Usage: ./shim_bench [-t seconds] [-f fps] [-i events/frame] [-v] [scenario...]
+// Every scenario runs a fresh child (this binary with --game) that plays PICO-8: it calls the interposed
+// SDL_Init / SDL_CreateWindow / SDL_PollEvent / SDL_UpdateWindowSurface with libmocksdl.so underneath.
+// The parent is the reference frontend on private channels (PICO_CHANNEL_PREFIX): it negotiates the
+// encoding, decodes every packet and checks each frame against the pattern the child drew, and writes
+// key events stamped with their send time. -f 0 presents as fast as possible (throughput).
+// Reported: presented and received frames/s, capture -> read latency percentiles, bytes per received
+// frame, syscalls per presented frame (child's /proc/self/io), input latency percentiles, mismatched
+// frames and, for the reconnect scenario, reader reopen -> first full frame.
+// The memset scenario times this executable's memset calls while the shim's RAM probe is armed
+// (PICO_RAM_PROBE=1), after it has seen the RAM block and removed itself, and in a run without the probe.
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <SDL2/SDL.h>
+
+// Wire format, see shim.c
+#define SYNC "PICO8SYNC"
+#define SYNC_SIZE 9
+#define TYPE_INDEX 9
+#define SEQ_INDEX 14
+#define CAPTURE_TS_INDEX 18
+#define PAYLOAD_OFFSET 22
+#define FB_SIZE 128
+#define PIXEL_SIZE (FB_SIZE * FB_SIZE * 4)
+#define PALETTE_SIZE (16 * 3)
+#define INDEXED_PIXEL_SIZE (FB_SIZE * FB_SIZE / 2)
+#define ROW_MASK_SIZE 16
+#define SHM_DOORBELL_SIZE 8
+#define SHM_HEADER_SIZE 64
+#define SHM_SLOT_HEADER_SIZE 16
+#define TELEMETRY_SIZE 32
+#define READY_SIZE 20
+
+#define IN_PACKET_SIZE 16
+#define EVENT_KEYEV 2
+#define EVENT_VIDMODE 4
+#define ENCODING_RGBA 0
+#define ENCODING_INDEXED 1
+#define FLAG_DELTA 0x01
+#define FLAG_SHM 0x02
+
+#define RESULT_FD 3 // Child -> parent: one result line
+#define STAMP_UNIT_US 16 // Input send time travels in the 16-bit keysym.mod, in 16 us units
+#define READ_SIZE (PAYLOAD_OFFSET + PIXEL_SIZE)
+#define REOPEN_GAP_MS 50 // Long enough for the shim to hit EPIPE and drop its end
+#define PICO8_RAM_SIZE 0x37000 // The allocation the shim's RAM probe waits for
+#define MEMSET_RUN_US 200000
+
+typedef struct {
+    const char* name;
+    int encoding;
+    int flags;
+    int changed_rows;  // Rows redrawn per present (128 = every row, 0 = static after the first frame)
+    int reconnect_ms;  // Reader closes and reopens the video FIFO this often (0 = never)
+} Scenario;
+
+static const Scenario scenarios[] = {
+    {"rgba", ENCODING_RGBA, 0, FB_SIZE, 0},
+    {"indexed", ENCODING_INDEXED, 0, FB_SIZE, 0},
+    {"rgba-delta", ENCODING_RGBA, FLAG_DELTA, 8, 0},
+    {"indexed-delta", ENCODING_INDEXED, FLAG_DELTA, 8, 0},
+    {"static-delta", ENCODING_INDEXED, FLAG_DELTA, 0, 0},
+    {"shm", ENCODING_RGBA, FLAG_SHM, FB_SIZE, 0},
+    {"reconnect", ENCODING_INDEXED, FLAG_DELTA, 8, 500},
+};
+#define SCENARIO_COUNT (int)(sizeof(scenarios) / sizeof(scenarios[0]))
+
+// PICO-8's default palette, XRGB
+static const uint32_t palette[16] = {
+    0x000000, 0x1D2B53, 0x7E2553, 0x008751, 0xAB5236, 0x5F574F, 0xC2C3C7, 0xFFF1E8,
+    0xFF004D, 0xFFA300, 0xFFEC27, 0x00E436, 0x29ADFF, 0x83769C, 0xFF77A8, 0xFFCCAA,
+};
+
+static int seconds = 3;
+static int fps = 60;
+static int events_per_frame = 1;
+static bool verbose = false;
+
+static uint64_t now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+// Same clock as the shim's capture timestamps
+static uint32_t wallclock_us32() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000ull + ts.tv_nsec / 1000);
+}
+
+// Present (1-based, the shim's FrameSeq) at which row was last redrawn. Rows are solid, one palette color.
+static uint32_t row_stamp(int row, uint32_t seq, int changed_rows) {
+    if (changed_rows >= FB_SIZE) return seq;
+    if (changed_rows <= 0) return 1;
+    for (uint32_t m = seq; m > 1; m--) {
+        if ((unsigned)(row - (int)(m * changed_rows % FB_SIZE) + FB_SIZE) % FB_SIZE < (unsigned)changed_rows) return m;
+    }
+    return 1;
+}
+
+// Not periodic in 16, so a redrawn row always really changes
+static uint32_t row_color(int row, uint32_t stamp) {
+    return palette[(row * 7 + stamp * 5 + stamp / 16) % 16];
+}
+
+typedef struct {
+    uint32_t* values;
+    size_t count, cap;
+} Samples;
+
+static void samples_add(Samples* s, uint32_t value) {
+    if (s->count == s->cap) {
+        s->cap = s->cap ? s->cap * 2 : 1024;
+        s->values = realloc(s->values, s->cap * sizeof(uint32_t));
+    }
+    s->values[s->count++] = value;
+}
+
+static int compare_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return x < y ? -1 : x > y;
+}
+
+// Sorts in place
+static double percentile_ms(Samples* s, double p) {
+    if (!s->count) return 0;
+    qsort(s->values, s->count, sizeof(uint32_t), compare_u32);
+    size_t i = (size_t)(p * (s->count - 1) + 0.5);
+    return s->values[i] / 1000.0;
+}
+
+// ---------------------------------------------------------------------------------------------------------
+// Child: a fake PICO-8 main loop on top of the shim
+
+static void read_io(unsigned long* syscalls) {
+    FILE* f = fopen("/proc/self/io", "r");
+    unsigned long value, total = 0;
+    char key[32];
+    while (f && fscanf(f, "%31[^:]: %lu\n", key, &value) == 2) {
+        if (strcmp(key, "syscr") == 0 || strcmp(key, "syscw") == 0) total += value;
+    }
+    if (f) fclose(f);
+    *syscalls = total;
+}
+
+static void draw(SDL_Surface* surface, uint32_t seq, int changed_rows) {
+    uint32_t* pixels = surface->pixels;
+    for (int row = 0; row < FB_SIZE; row++) {
+        bool redraw = seq == 1 || changed_rows >= FB_SIZE ||
+                      (changed_rows > 0 && row_stamp(row, seq, changed_rows) == seq);
+        if (!redraw) continue;
+        uint32_t color = row_color(row, seq);
+        for (int x = 0; x < FB_SIZE; x++) pixels[row * FB_SIZE + x] = color;
+    }
+}
+
+static int run_game(int changed_rows) {
+    // PICO-8 calls SDL_Init twice, the shim only sets up on the second one
+    SDL_Init(0);
+    SDL_Init(SDL_INIT_VIDEO);
+    SDL_Window* window = SDL_CreateWindow("shim_bench", 0, 0, FB_SIZE, FB_SIZE, 0);
+    SDL_Surface* surface = SDL_GetWindowSurface(window);
+
+    Samples input_latency = {0};
+    unsigned long io_start, io_end;
+    read_io(&io_start);
+    uint64_t start = now_us(), end = start + seconds * 1000000ull;
+    uint64_t frame_us = fps > 0 ? 1000000 / fps : 0;
+    uint32_t seq = 0;
+    for (uint64_t next = start; now_us() < end; ) {
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
+                uint16_t sent = event.key.keysym.mod;
+                uint16_t now = (uint16_t)(wallclock_us32() / STAMP_UNIT_US);
+                samples_add(&input_latency, (uint16_t)(now - sent) * STAMP_UNIT_US);
+            }
+        }
+        draw(surface, ++seq, changed_rows);
+        SDL_UpdateWindowSurface(window);
+        if (frame_us) {
+            next += frame_us;
+            struct timespec ts = {(time_t)(next / 1000000), (long)(next % 1000000) * 1000};
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+        }
+    }
+    read_io(&io_end);
+    dprintf(RESULT_FD, "%u %lu %zu %.3f %.3f\n", seq, io_end - io_start, input_latency.count,
+            percentile_ms(&input_latency, 0.5), percentile_ms(&input_latency, 0.99));
+    fflush(stdout);
+    _exit(0); // Don't wait for the detached sender thread
+}
+
+static const size_t memset_sizes[] = {16, 256, 4096, FB_SIZE * FB_SIZE * 4, PICO8_RAM_SIZE - 4096};
+#define MEMSET_SIZE_COUNT (int)(sizeof(memset_sizes) / sizeof(memset_sizes[0]))
+
+// ns per call to memset by name, i.e. through this executable's GOT slot, the one the probe patches
+static double time_memset(uint8_t* buf, size_t size) {
+    unsigned long calls = 0;
+    uint64_t start = now_us(), elapsed;
+    do {
+        for (int i = 0; i < 1024; i++, calls++) {
+            memset(buf, (int)(calls & 0xff), size);
+            __asm__ volatile("" ::: "memory"); // Every store is observable, none can be merged away
+        }
+    } while ((elapsed = now_us() - start) < MEMSET_RUN_US);
+    return elapsed * 1000.0 / calls;
+}
+
+// One line per size: ns before and after PICO-8's RAM memset
+static int run_memset() {
+    uint8_t* ram = malloc(PICO8_RAM_SIZE);
+    if (!ram) return 1;
+    double before[MEMSET_SIZE_COUNT];
+    for (int i = 0; i < MEMSET_SIZE_COUNT; i++) before[i] = time_memset(ram, memset_sizes[i]);
+    memset(ram, 0, PICO8_RAM_SIZE); // What PICO-8 does at startup
+    for (int i = 0; i < MEMSET_SIZE_COUNT; i++) {
+        dprintf(RESULT_FD, "%zu %.3f %.3f\n", memset_sizes[i], before[i], time_memset(ram, memset_sizes[i]));
+    }
+    free(ram);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------------------------------------
+// Parent: reference frontend
+
+typedef struct {
+    const Scenario* sc;
+    uint32_t frame[FB_SIZE * FB_SIZE]; // Decoded XRGB
+    bool have_full;                     // A full frame arrived since (re)connecting, deltas apply
+    uint8_t* shm;
+    size_t shm_size;
+    unsigned long received, mismatched, bytes, reconnects;
+    Samples latency, reopen;
+    uint64_t reopened_at;
+} Reader;
+
+static long packet_size(const uint8_t* p, size_t available) {
+    size_t rows = 0;
+    switch (p[TYPE_INDEX]) {
+    case '_': return PAYLOAD_OFFSET + PIXEL_SIZE;
+    case 'I': return PAYLOAD_OFFSET + PALETTE_SIZE + INDEXED_PIXEL_SIZE;
+    case 'K': return PAYLOAD_OFFSET;
+    case 'S': return PAYLOAD_OFFSET + SHM_DOORBELL_SIZE;
+    case 'T': return PAYLOAD_OFFSET + TELEMETRY_SIZE;
+    case 'R': return PAYLOAD_OFFSET + READY_SIZE;
+    case 'd':
+    case 'i': {
+        size_t mask_at = PAYLOAD_OFFSET + (p[TYPE_INDEX] == 'i' ? PALETTE_SIZE : 0);
+        if (available < mask_at + ROW_MASK_SIZE) return 0;
+        for (int i = 0; i < ROW_MASK_SIZE; i++) rows += __builtin_popcount(p[mask_at + i]);
+        return mask_at + ROW_MASK_SIZE + rows * FB_SIZE * (p[TYPE_INDEX] == 'i' ? 1 : 8) / 2;
+    }
+    }
+    return -1;
+}
+
+static bool row_in_mask(const uint8_t* mask, int row) {
+    return !mask || (mask[row >> 3] & (1 << (row & 7)));
+}
+
+// RGBA rows (little endian 0xAABBGGRR) back to XRGB
+static void decode_rgba(Reader* r, const uint8_t* mask, const uint8_t* src) {
+    for (int row = 0; row < FB_SIZE; row++) {
+        if (!row_in_mask(mask, row)) continue;
+        for (int x = 0; x < FB_SIZE; x++, src += 4) r->frame[row * FB_SIZE + x] = src[0] << 16 | src[1] << 8 | src[2];
+    }
+}
+
+static void decode_indexed(Reader* r, const uint8_t* palette_rgb, const uint8_t* mask, const uint8_t* src) {
+    int i = 0;
+    for (int row = 0; row < FB_SIZE; row++) {
+        if (!row_in_mask(mask, row)) continue;
+        for (int x = 0; x < FB_SIZE; x++, i++) {
+            const uint8_t* c = palette_rgb + ((src[i >> 1] >> ((i & 1) * 4)) & 0x0F) * 3;
+            r->frame[row * FB_SIZE + x] = c[0] << 16 | c[1] << 8 | c[2];
+        }
+    }
+}
+
+static bool decode_shm(Reader* r, const uint8_t* doorbell) {
+    if (!r->shm) return false;
+    uint32_t slots, slot_size, seq, type, length;
+    memcpy(&slots, r->shm + 8, 4);
+    memcpy(&slot_size, r->shm + 12, 4);
+    memcpy(&seq, doorbell + 4, 4);
+    if (doorbell[0] >= slots || SHM_HEADER_SIZE + (size_t)(doorbell[0] + 1) * slot_size > r->shm_size) return false;
+    const uint8_t* slot = r->shm + SHM_HEADER_SIZE + (size_t)doorbell[0] * slot_size;
+    if (__atomic_load_n((const uint32_t*)slot, __ATOMIC_ACQUIRE) != seq) return false; // Already overwritten
+    memcpy(&type, slot + 4, 4);
+    memcpy(&length, slot + 8, 4);
+    if (type == 'I') decode_indexed(r, slot + SHM_SLOT_HEADER_SIZE, NULL, slot + SHM_SLOT_HEADER_SIZE + PALETTE_SIZE);
+    else decode_rgba(r, NULL, slot + SHM_SLOT_HEADER_SIZE);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n((const uint32_t*)slot, __ATOMIC_RELAXED) == seq; // Torn if it moved meanwhile
+}
+
+static void open_shm(Reader* r, const char* path) {
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size < SHM_HEADER_SIZE) {
+        if (fd >= 0) close(fd);
+        return;
+    }
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map != MAP_FAILED) {
+        r->shm = map;
+        r->shm_size = st.st_size;
+    }
+}
+
+static void check_frame(Reader* r, uint32_t seq) {
+    for (int row = 0; row < FB_SIZE; row++) {
+        uint32_t expected = row_color(row, row_stamp(row, seq, r->sc->changed_rows));
+        if (r->frame[row * FB_SIZE] != expected || r->frame[row * FB_SIZE + FB_SIZE - 1] != expected) {
+            r->mismatched++;
+            if (verbose) fprintf(stderr, "  frame %u row %d: %06x, expected %06x\n", seq, row, r->frame[row * FB_SIZE], expected);
+            return;
+        }
+    }
+}
+
+static void handle_packet(Reader* r, const uint8_t* p, size_t size) {
+    uint8_t type = p[TYPE_INDEX];
+    const uint8_t* payload = p + PAYLOAD_OFFSET;
+    uint32_t seq, capture_us;
+    memcpy(&seq, p + SEQ_INDEX, 4);
+    memcpy(&capture_us, p + CAPTURE_TS_INDEX, 4);
+    r->bytes += size;
+    bool full = type == '_' || type == 'I' || type == 'S';
+    bool delta = type == 'd' || type == 'i';
+    if (!full && !delta) return;
+    if (delta && !r->have_full) return; // Based on a frame this connection never saw
+
+    switch (type) {
+    case '_': decode_rgba(r, NULL, payload); break;
+    case 'I': decode_indexed(r, payload, NULL, payload + PALETTE_SIZE); break;
+    case 'd': decode_rgba(r, payload, payload + ROW_MASK_SIZE); break;
+    case 'i': decode_indexed(r, payload, payload + PALETTE_SIZE, payload + PALETTE_SIZE + ROW_MASK_SIZE); break;
+    case 'S':
+        if (!decode_shm(r, payload)) return; // Counted as dropped, like the frontend does
+        break;
+    }
+    if (full && !r->have_full) {
+        r->have_full = true;
+        if (r->reopened_at) samples_add(&r->reopen, (uint32_t)(now_us() - r->reopened_at));
+        r->reopened_at = 0;
+    }
+    r->received++;
+    samples_add(&r->latency, wallclock_us32() - capture_us);
+    check_frame(r, seq);
+}
+
+static void send_packet(int fd, const uint8_t* packet) {
+    if (fd >= 0 && write(fd, packet, IN_PACKET_SIZE) != IN_PACKET_SIZE && verbose) perror("input FIFO");
+}
+
+static void send_vidmode(int in_fd, const Scenario* sc) {
+    uint8_t packet[IN_PACKET_SIZE] = {EVENT_VIDMODE, (uint8_t)sc->encoding, (uint8_t)sc->flags};
+    send_packet(in_fd, packet);
+}
+
+static void send_keys(int in_fd, uint32_t* key_seq) {
+    for (int i = 0; i < events_per_frame; i++) {
+        uint16_t stamp = (uint16_t)(wallclock_us32() / STAMP_UNIT_US);
+        uint8_t packet[IN_PACKET_SIZE] = {EVENT_KEYEV, 4 + (*key_seq / 2) % 26, !(*key_seq & 1), 0,
+                                          (uint8_t)stamp, (uint8_t)(stamp >> 8)};
+        (*key_seq)++;
+        send_packet(in_fd, packet);
+    }
+}
+
+static int remove_entry(const char* path, const struct stat* st, int type, struct FTW* ftw) {
+    (void)st;
+    (void)type;
+    (void)ftw;
+    remove(path);
+    return 0;
+}
+
+static int run_scenario(const Scenario* sc, const char* self) {
+    char dir[] = "/tmp/shim_bench.XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror(dir);
+        return -1;
+    }
+    // Sized for exactly what goes in them, so the compiler can see nothing gets truncated
+    char prefix[sizeof(dir) + sizeof("/pico8")];
+    char vid_path[sizeof(prefix) + sizeof(".vid")], in_path[sizeof(prefix) + sizeof(".in")];
+    char fb_path[sizeof(prefix) + sizeof(".fb")];
+    snprintf(prefix, sizeof(prefix), "%s/pico8", dir);
+    snprintf(vid_path, sizeof(vid_path), "%s.vid", prefix);
+    snprintf(in_path, sizeof(in_path), "%s.in", prefix);
+    snprintf(fb_path, sizeof(fb_path), "%s.fb", prefix);
+    if (mkfifo(vid_path, 0666) != 0 || mkfifo(in_path, 0666) != 0) {
+        perror(vid_path);
+        return -1;
+    }
+
+    int result_pipe[2];
+    if (pipe(result_pipe) != 0) return -1;
+    int vid_fd = open(vid_path, O_RDONLY | O_NONBLOCK);
+    // Read-write so the open can't fail for lack of a reader (Linux): the shim finds the VIDMODE
+    // request waiting whenever it gets to its end, like with the frontend's blocking open
+    int in_fd = open(in_path, O_RDWR | O_NONBLOCK);
+    send_vidmode(in_fd, sc);
+    uint64_t start = now_us();
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(result_pipe[1], RESULT_FD);
+        if (!verbose) {
+            int null_fd = open("/dev/null", O_WRONLY);
+            dup2(null_fd, STDOUT_FILENO);
+        }
+        char rows[16];
+        snprintf(rows, sizeof(rows), "%d", sc->changed_rows);
+        setenv("PICO_CHANNEL_PREFIX", prefix, 1);
+        execl(self, self, "--game", rows, (char*)NULL);
+        _exit(127);
+    }
+    close(result_pipe[1]);
+
+    Reader* r = calloc(1, sizeof(Reader));
+    r->sc = sc;
+    uint8_t* buffer = malloc(READ_SIZE * 2);
+    size_t used = 0;
+    uint32_t key_seq = 0;
+    uint64_t end = start + seconds * 1000000ull + 200000; // Child runs `seconds` after its own startup
+    uint64_t next_reconnect = sc->reconnect_ms ? start + sc->reconnect_ms * 1000ull : 0;
+    for (uint64_t now = start; now < end; now = now_us()) {
+        if (!r->shm && (sc->flags & FLAG_SHM) && r->received + r->bytes > 0) {
+            open_shm(r, fb_path);
+        }
+        if (next_reconnect && now >= next_reconnect && r->have_full) {
+            // Frontend reset: drop the reader end, come back, renegotiate
+            close(vid_fd);
+            usleep(REOPEN_GAP_MS * 1000);
+            vid_fd = open(vid_path, O_RDONLY | O_NONBLOCK);
+            used = 0;
+            r->have_full = false;
+            r->reconnects++;
+            r->reopened_at = now_us();
+            send_vidmode(in_fd, sc);
+            next_reconnect = now_us() + sc->reconnect_ms * 1000ull;
+        }
+
+        struct pollfd pfd = {.fd = vid_fd, .events = POLLIN};
+        if (poll(&pfd, 1, 10) <= 0) continue;
+        ssize_t n = read(vid_fd, buffer + used, READ_SIZE * 2 - used);
+        if (n <= 0) {
+            if (n == 0 || errno != EAGAIN) break; // Child gone
+            continue;
+        }
+        used += n;
+
+        size_t pos = 0;
+        while (used - pos >= PAYLOAD_OFFSET) {
+            uint8_t* p = buffer + pos;
+            if (memcmp(p, SYNC, SYNC_SIZE) != 0) {
+                pos++;
+                continue;
+            }
+            long size = packet_size(p, used - pos);
+            if (size < 0) {
+                pos++;
+                continue;
+            }
+            if (size == 0 || used - pos < (size_t)size) break;
+            unsigned long before = r->received;
+            handle_packet(r, p, size);
+            if (r->received != before) send_keys(in_fd, &key_seq);
+            pos += size;
+        }
+        memmove(buffer, buffer + pos, used - pos);
+        used -= pos;
+    }
+
+    // Child result: presented frames, syscalls, input events, input p50, p99
+    unsigned presented = 0;
+    unsigned long syscalls = 0;
+    size_t inputs = 0;
+    double in_p50 = 0, in_p99 = 0;
+    FILE* result = fdopen(result_pipe[0], "r");
+    int got = result ? fscanf(result, "%u %lu %zu %lf %lf", &presented, &syscalls, &inputs, &in_p50, &in_p99) : 0;
+    if (result) fclose(result);
+    close(vid_fd);
+    if (in_fd >= 0) close(in_fd);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (got != 5) {
+        fprintf(stderr, "%s: game process failed (status %d)\n", sc->name, status);
+    }
+
+    double elapsed = seconds;
+    printf("%-14s %8.1f %8.1f %7.2f %7.2f %7.2f %9.0f %8.1f %7.2f %7.2f %5lu", sc->name, presented / elapsed,
+           r->received / elapsed, percentile_ms(&r->latency, 0.5), percentile_ms(&r->latency, 0.95),
+           percentile_ms(&r->latency, 0.99), r->received ? (double)r->bytes / r->received : 0.0,
+           presented ? (double)syscalls / presented : 0.0, in_p50, in_p99, r->mismatched);
+    if (r->reconnects) {
+        printf("  %lu reopens, first full frame p50 %.1f ms max %.1f ms", r->reconnects,
+               percentile_ms(&r->reopen, 0.5), percentile_ms(&r->reopen, 1.0));
+    }
+    printf("\n");
+    fflush(stdout);
+
+    bool failed = got != 5 || r->mismatched || !r->received || (r->reconnects && r->reopen.count < r->reconnects);
+    if (r->shm) munmap(r->shm, r->shm_size);
+    free(r->latency.values);
+    free(r->reopen.values);
+    free(r);
+    free(buffer);
+    nftw(dir, remove_entry, 8, FTW_DEPTH | FTW_PHYS);
+    return failed ? 1 : 0;
+}
+
+// probe: 1 arms the shim's RAM probe (shim_bench isn't a known PICO-8 build), 0 leaves the GOT alone
+static int memset_child(const char* self, bool probe, double before[], double after[]) {
+    int result_pipe[2];
+    if (pipe(result_pipe) != 0) return -1;
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(result_pipe[1], RESULT_FD);
+        if (!verbose) {
+            int null_fd = open("/dev/null", O_WRONLY);
+            dup2(null_fd, STDOUT_FILENO);
+        }
+        setenv("PICO_RAM_PROBE", probe ? "1" : "0", 1);
+        execl(self, self, "--memset", (char*)NULL);
+        _exit(127);
+    }
+    close(result_pipe[1]);
+    int got = 0;
+    FILE* result = fdopen(result_pipe[0], "r");
+    size_t size;
+    while (result && got < MEMSET_SIZE_COUNT && fscanf(result, "%zu %lf %lf", &size, &before[got], &after[got]) == 3) got++;
+    if (result) fclose(result);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return got == MEMSET_SIZE_COUNT ? 0 : -1;
+}
+
+static int run_memset_bench(const char* self) {
+    double armed[MEMSET_SIZE_COUNT], locked[MEMSET_SIZE_COUNT], native[2][MEMSET_SIZE_COUNT];
+    if (memset_child(self, true, armed, locked) != 0 || memset_child(self, false, native[0], native[1]) != 0) {
+        fprintf(stderr, "memset: bench process failed\n");
+        return 1;
+    }
+    printf("%-14s %8s %9s %9s %9s %7s\n", "memset bytes", "", "armed ns", "locked ns", "native ns", "ratio");
+    for (int i = 0; i < MEMSET_SIZE_COUNT; i++) {
+        double base = (native[0][i] + native[1][i]) / 2;
+        printf("%-14zu %8s %9.2f %9.2f %9.2f %7.2f\n", memset_sizes[i], "", armed[i], locked[i], base, locked[i] / base);
+    }
+    fflush(stdout);
+    return 0;
+}
+
+static void usage() {
+    fprintf(stderr, "Usage: shim_bench [-t seconds] [-f fps] [-i events/frame] [-v] [scenario...]\nScenarios:");
+    for (int i = 0; i < SCENARIO_COUNT; i++) fprintf(stderr, " %s", scenarios[i].name);
+    fprintf(stderr, " memset\n");
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    if (argc == 3 && strcmp(argv[1], "--game") == 0) {
+        // Child inherits the settings through the environment
+        if (getenv("SHIM_BENCH_SECONDS")) seconds = atoi(getenv("SHIM_BENCH_SECONDS"));
+        if (getenv("SHIM_BENCH_FPS")) fps = atoi(getenv("SHIM_BENCH_FPS"));
+        return run_game(atoi(argv[2]));
+    }
+    if (argc == 2 && strcmp(argv[1], "--memset") == 0) return run_memset();
+
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        const char* opt = argv[arg];
+        if (strcmp(opt, "-v") == 0) {
+            verbose = true;
+        } else if (strcmp(opt, "-t") == 0 && arg + 1 < argc) {
+            seconds = atoi(argv[++arg]);
+            if (seconds < 1) seconds = 1;
+        } else if (strcmp(opt, "-f") == 0 && arg + 1 < argc) {
+            fps = atoi(argv[++arg]);
+            if (fps < 0) fps = 0;
+        } else if (strcmp(opt, "-i") == 0 && arg + 1 < argc) {
+            events_per_frame = atoi(argv[++arg]);
+            if (events_per_frame < 0) events_per_frame = 0;
+        } else {
+            usage();
+        }
+    }
+    char env[16];
+    snprintf(env, sizeof(env), "%d", seconds);
+    setenv("SHIM_BENCH_SECONDS", env, 1);
+    snprintf(env, sizeof(env), "%d", fps);
+    setenv("SHIM_BENCH_FPS", env, 1);
+    signal(SIGPIPE, SIG_IGN);
+
+    char* self = realpath("/proc/self/exe", NULL);
+    if (!self) {
+        perror("/proc/self/exe");
+        return 1;
+    }
+    printf("shim_bench: %d s per scenario, %s fps, %d input events per received frame\n", seconds,
+           fps ? env : "unlimited", events_per_frame);
+    int failed = 0, ran = 0;
+    for (int i = 0; i < SCENARIO_COUNT; i++) {
+        bool selected = arg >= argc;
+        for (int a = arg; a < argc; a++) selected |= strcmp(argv[a], scenarios[i].name) == 0;
+        if (!selected) continue;
+        if (!ran++) {
+            printf("%-14s %8s %8s %7s %7s %7s %9s %8s %7s %7s %5s\n", "scenario", "present/s", "recv/s", "lat p50",
+                   "p95", "p99", "bytes/fr", "sysc/fr", "in p50", "in p99", "bad");
+        }
+        failed += run_scenario(&scenarios[i], self) != 0;
+    }
+    bool memset_selected = arg >= argc;
+    for (int a = arg; a < argc; a++) memset_selected |= strcmp(argv[a], "memset") == 0;
+    if (memset_selected) {
+        if (ran++) printf("\n");
+        failed += run_memset_bench(self) != 0;
+    }
+    if (!ran) usage();
+    free(self);
+    return failed ? 1 : 0;
+}